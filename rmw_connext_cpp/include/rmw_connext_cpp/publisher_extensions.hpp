@@ -0,0 +1,201 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_CPP__PUBLISHER_EXTENSIONS_HPP_
+#define RMW_CONNEXT_CPP__PUBLISHER_EXTENSIONS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rmw/rmw.h"
+#include "rmw_connext_cpp/visibility_control.h"
+
+namespace rmw_connext_cpp
+{
+
+/// Return code of publish_nonblocking() when publishing would have blocked.
+/**
+ * The codes defined in rmw/ret_types.h all stay well below 1000, so this value can't be
+ * mistaken for one of them.
+ */
+constexpr rmw_ret_t ret_would_block = 1000;
+
+/// A contiguous piece of a serialized message, see publish_serialized_segments().
+struct SerializedSegment
+{
+  /// First byte of the segment.
+  const uint8_t * data;
+  /// Number of bytes in the segment.
+  size_t length;
+};
+
+/// Release the memory of the serialization buffer reused by a publisher.
+/**
+ * Each publisher keeps the buffer it serializes messages into, grown to the
+ * largest message published so far.
+ * This function gives that memory back, e.g. after a burst of unusually large
+ * messages; the buffer is allocated again on the next publish.
+ *
+ * \param[in] publisher publisher whose serialization buffer is released
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if the publisher is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+shrink_publisher_serialization_buffer(rmw_publisher_t * publisher);
+
+/// Totals of what a publisher did since it was created.
+struct PublisherStatistics
+{
+  /// Number of messages successfully written.
+  uint64_t published_messages;
+  /// Number of serialized bytes successfully written, encapsulation headers included.
+  /// For compressed topics, this is the compressed size.
+  uint64_t published_bytes;
+  /// Total time spent serializing messages, in nanoseconds.
+  uint64_t serialization_time_ns;
+  /// Total time spent compressing serialized messages of compressed topics, in nanoseconds.
+  uint64_t compression_time_ns;
+  /// Total time spent writing serialized messages to the data writer, in nanoseconds.
+  uint64_t write_time_ns;
+  /// Number of writes that timed out, or were refused by publish_nonblocking(), because the
+  /// publisher had no room for the message.
+  uint64_t blocked_writes;
+  /// Number of messages that failed to be serialized or written for any other reason,
+  /// each counted once.
+  uint64_t failed_writes;
+};
+
+/// Get the statistics of a publisher.
+/**
+ * The counters are updated with relaxed atomic operations on every publish, so reading
+ * them is cheap and can be done while other threads publish, but the values may not all
+ * come from the same instant.
+ * Serialization time includes copying plain messages, which skip the type support.
+ *
+ * \param[in] publisher publisher to get the statistics of
+ * \param[out] statistics filled with the publisher statistics
+ * \return `RMW_RET_OK` if successful, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if any argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+get_publisher_statistics(const rmw_publisher_t * publisher, PublisherStatistics * statistics);
+
+/// Publish several ROS messages at once.
+/**
+ * The messages are serialized one after the other into the publisher's buffer and
+ * written in order, while checking the arguments and locking the publisher only once.
+ * When the data writer uses DDS batching, the batch is flushed after the last message,
+ * so the messages don't wait for the batch to fill up or its flush delay to expire.
+ *
+ * Publishing stops at the first message that fails.
+ *
+ * \param[in] publisher publisher to publish with
+ * \param[in] ros_messages array of `count` pointers to the messages to publish
+ * \param[in] count number of messages
+ * \param[out] published_count number of messages published, may be `NULL`
+ * \return `RMW_RET_OK` if all messages were published, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if any argument or message is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_batch(
+  const rmw_publisher_t * publisher,
+  const void * const * ros_messages,
+  size_t count,
+  size_t * published_count);
+
+/// Publish several serialized messages at once.
+/**
+ * Same as publish_batch(), for messages that are already serialized.
+ * Publishing stops at the first message without data, the messages before it being published.
+ *
+ * \param[in] publisher publisher to publish with
+ * \param[in] serialized_messages array of `count` serialized messages
+ * \param[in] count number of messages
+ * \param[out] published_count number of messages published, may be `NULL`
+ * \return `RMW_RET_OK` if all messages were published, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if any argument is `NULL` or a message is empty, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_serialized_batch(
+  const rmw_publisher_t * publisher,
+  const rmw_serialized_message_t * serialized_messages,
+  size_t count,
+  size_t * published_count);
+
+/// Publish a serialized message made of several segments.
+/**
+ * The segments are concatenated in order to form the serialized message, encapsulation
+ * header included, as it would be passed to rmw_publish_serialized_message().
+ * They are gathered into the publisher's own serialization buffer, which is reused across
+ * publishes, so callers holding e.g. a header and a body in separate buffers don't have
+ * to allocate and concatenate them first.
+ *
+ * \param[in] publisher publisher to publish with
+ * \param[in] segments array of `count` segments, segments of length 0 may have `NULL` data
+ * \param[in] count number of segments
+ * \return `RMW_RET_OK` if the message was published, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if any argument is `NULL` or the message is empty, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_serialized_segments(
+  const rmw_publisher_t * publisher,
+  const SerializedSegment * segments,
+  size_t count);
+
+/// Publish a ROS message, unless that would block the caller.
+/**
+ * rmw_publish() blocks for up to the reliability max_blocking_time when the history of a
+ * keep all publisher is full, or the send window of a reliable publisher is full, until
+ * enough samples are acknowledged.
+ * This function checks the data writer cache status and the reliable writer window first,
+ * and returns `ret_would_block` without publishing if the write would block,
+ * so the caller can drop, coalesce or retry the message on its own schedule.
+ *
+ * \param[in] publisher publisher to publish with
+ * \param[in] ros_message message to publish
+ * \return `RMW_RET_OK` if the message was published, or
+ * \return `ret_would_block` if the message was not published because the
+ *   publisher has no room for it, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if any argument is `NULL`, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if the publisher is from a different
+ *   rmw implementation, or
+ * \return `RMW_RET_ERROR` if an unexpected error occurs.
+ */
+RMW_CONNEXT_CPP_PUBLIC
+rmw_ret_t
+publish_nonblocking(const rmw_publisher_t * publisher, const void * ros_message);
+
+}  // namespace rmw_connext_cpp
+
+#endif  // RMW_CONNEXT_CPP__PUBLISHER_EXTENSIONS_HPP_
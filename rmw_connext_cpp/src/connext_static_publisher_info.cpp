@@ -14,6 +14,15 @@
 
 #include "connext_static_publisher_info.hpp"
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include "rmw/error_handling.h"
+
+#include "rmw_connext_shared_cpp/compression.hpp"
 #include "rmw_connext_shared_cpp/event_converter.hpp"
 #include "rmw_connext_shared_cpp/qos.hpp"
 
@@ -90,3 +99,241 @@ DDS::Entity * ConnextStaticPublisherInfo::get_entity()
 {
   return topic_writer_;
 }
+
+namespace
+{
+
+/// Nanoseconds elapsed on the steady clock since start.
+uint64_t
+elapsed_ns(const std::chrono::steady_clock::time_point & start)
+{
+  return static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count());
+}
+
+}  // namespace
+
+bool ConnextStaticPublisherInfo::serialize_plain(
+  const void * ros_message, rcutils_uint8_array_t * serialized_message)
+{
+  // pad the payload to a multiple of 4 bytes, as the type support does
+  const size_t padding = (4 - type_info_.cdr_size % 4) % 4;
+  const size_t length = encapsulation_header_size + type_info_.cdr_size + padding;
+  if (serialized_message->buffer_capacity < length) {
+    if (RCUTILS_RET_OK != rcutils_uint8_array_resize(serialized_message, length)) {
+      RMW_SET_ERROR_MSG("failed to resize serialization buffer");
+      return false;
+    }
+  }
+  uint8_t * buffer = serialized_message->buffer;
+  // encapsulation identifier (CDR_BE or CDR_LE) followed by the options,
+  // whose two least significant bits hold the amount of padding
+  buffer[0] = 0x00;
+  buffer[1] = is_host_little_endian() ? 0x01 : 0x00;
+  buffer[2] = 0x00;
+  buffer[3] = static_cast<uint8_t>(padding);
+  memcpy(buffer + encapsulation_header_size, ros_message, type_info_.cdr_size);
+  memset(buffer + encapsulation_header_size + type_info_.cdr_size, 0, padding);
+  serialized_message->buffer_length = length;
+  return true;
+}
+
+bool ConnextStaticPublisherInfo::serialize(
+  const void * ros_message, rcutils_uint8_array_t * serialized_message)
+{
+  const auto start = std::chrono::steady_clock::now();
+  bool serialized = serialize_stream(ros_message, serialized_message);
+  ConnextPublisherCounters::add(counters_.serialization_time_ns, elapsed_ns(start));
+  return serialized;
+}
+
+bool ConnextStaticPublisherInfo::serialize_stream(
+  const void * ros_message, rcutils_uint8_array_t * serialized_message)
+{
+  if (type_info_.is_cdr_compatible) {
+    return serialize_plain(ros_message, serialized_message);
+  }
+  if (!callbacks_->to_cdr_stream(ros_message, serialized_message)) {
+    RMW_SET_ERROR_MSG("failed to convert ros_message to cdr stream");
+    return false;
+  }
+  // to_cdr_stream only reallocates when the current capacity is too small for the message,
+  // and the new buffer is then exactly as large as the message: record it as the new capacity.
+  if (serialized_message->buffer_capacity < serialized_message->buffer_length) {
+    serialized_message->buffer_capacity = serialized_message->buffer_length;
+  }
+  if (serialized_message->buffer_length == 0) {
+    RMW_SET_ERROR_MSG("no message length set");
+    return false;
+  }
+  if (!serialized_message->buffer) {
+    RMW_SET_ERROR_MSG("no serialized message attached");
+    return false;
+  }
+  return true;
+}
+
+const rcutils_uint8_array_t * ConnextStaticPublisherInfo::compress(
+  const rcutils_uint8_array_t * cdr_stream)
+{
+  if (
+    !is_compression_enabled_ ||
+    cdr_stream->buffer_length < rmw_connext_shared_cpp::min_compressed_message_size)
+  {
+    return nullptr;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  compression_buffer_.buffer_length = 0;
+  if (
+    compression_buffer_.buffer_capacity < cdr_stream->buffer_length &&
+    RCUTILS_RET_OK != rcutils_uint8_array_resize(&compression_buffer_, cdr_stream->buffer_length))
+  {
+    // not fatal, the message is sent uncompressed
+    rmw_reset_error();
+  } else {
+    compression_buffer_.buffer_length = rmw_connext_shared_cpp::compress_serialized_message(
+      cdr_stream->buffer, cdr_stream->buffer_length,
+      compression_buffer_.buffer, compression_buffer_.buffer_capacity);
+  }
+  ConnextPublisherCounters::add(counters_.compression_time_ns, elapsed_ns(start));
+  return 0 == compression_buffer_.buffer_length ? nullptr : &compression_buffer_;
+}
+
+bool ConnextStaticPublisherInfo::publish(
+  const void * ros_message, rcutils_uint8_array_t * serialized_message)
+{
+  DDS::ReturnCode_t status = DDS::RETCODE_ERROR;
+  size_t written_length = 0;
+  if (serialize(ros_message, serialized_message)) {
+    status = write_stream(serialized_message, written_length);
+  }
+  return count_publish(status, written_length);
+}
+
+bool ConnextStaticPublisherInfo::write(const rcutils_uint8_array_t * cdr_stream)
+{
+  size_t written_length = 0;
+  DDS::ReturnCode_t status = write_stream(cdr_stream, written_length);
+  return count_publish(status, written_length);
+}
+
+DDS::ReturnCode_t ConnextStaticPublisherInfo::write_stream(
+  const rcutils_uint8_array_t * cdr_stream, size_t & written_length)
+{
+  // The sample is owned by the publisher and only borrows the cdr stream while writing.
+  ConnextStaticSerializedData * instance = sample_;
+  if (!instance) {
+    RMW_SET_ERROR_MSG("dds message instance is null");
+    return DDS::RETCODE_ERROR;
+  }
+
+  const rcutils_uint8_array_t * compressed_stream = compress(cdr_stream);
+  if (compressed_stream) {
+    cdr_stream = compressed_stream;
+  }
+
+  if (cdr_stream->buffer_length > static_cast<size_t>((std::numeric_limits<DDS_Long>::max)())) {
+    RMW_SET_ERROR_MSG("cdr_stream->buffer_length unexpectedly larger than DDS_Long's max value");
+    return DDS::RETCODE_ERROR;
+  }
+  if (!instance->serialized_data.loan_contiguous(
+      reinterpret_cast<DDS::Octet *>(cdr_stream->buffer),
+      static_cast<DDS::Long>(cdr_stream->buffer_length),
+      static_cast<DDS::Long>(cdr_stream->buffer_length)))
+  {
+    RMW_SET_ERROR_MSG("failed to loan memory for message");
+    return DDS::RETCODE_ERROR;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  DDS::ReturnCode_t status = data_writer_->write(*instance, DDS::HANDLE_NIL);
+  ConnextPublisherCounters::add(counters_.write_time_ns, elapsed_ns(start));
+
+  if (!instance->serialized_data.unloan()) {
+    fprintf(stderr, "failed to return loaned memory\n");
+    status = DDS::RETCODE_ERROR;
+  }
+  written_length = cdr_stream->buffer_length;
+  return status;
+}
+
+bool ConnextStaticPublisherInfo::count_publish(DDS::ReturnCode_t status, size_t written_length)
+{
+  if (DDS::RETCODE_OK == status) {
+    ConnextPublisherCounters::add(counters_.published_messages, 1);
+    ConnextPublisherCounters::add(counters_.published_bytes, written_length);
+  } else if (DDS::RETCODE_TIMEOUT == status) {
+    ConnextPublisherCounters::add(counters_.blocked_writes, 1);
+  } else {
+    ConnextPublisherCounters::add(counters_.failed_writes, 1);
+  }
+  return status == DDS::RETCODE_OK;
+}
+
+namespace
+{
+
+int64_t
+to_int64(const DDS::SequenceNumber_t & sequence_number)
+{
+  return (static_cast<int64_t>(sequence_number.high) << 32) + sequence_number.low;
+}
+
+}  // namespace
+
+bool ConnextStaticPublisherInfo::check_would_block(bool & would_block)
+{
+  would_block = false;
+  if (is_keep_all_ && DDS::LENGTH_UNLIMITED != max_samples_) {
+    DDS::DataWriterCacheStatus cache_status;
+    if (DDS::RETCODE_OK != data_writer_->get_datawriter_cache_status(cache_status)) {
+      RMW_SET_ERROR_MSG("failed to get data writer cache status");
+      return false;
+    }
+    if (cache_status.sample_count >= max_samples_) {
+      would_block = true;
+      return true;
+    }
+  }
+  if (is_send_window_limited_) {
+    DDS::DataWriterProtocolStatus protocol_status;
+    if (DDS::RETCODE_OK != data_writer_->get_datawriter_protocol_status(protocol_status)) {
+      RMW_SET_ERROR_MSG("failed to get data writer protocol status");
+      return false;
+    }
+    const int64_t unacknowledged_samples =
+      to_int64(protocol_status.last_available_sample_sequence_number) -
+      to_int64(protocol_status.first_unacknowledged_sample_sequence_number) + 1;
+    if (unacknowledged_samples >= protocol_status.send_window_size) {
+      would_block = true;
+    }
+  }
+  return true;
+}
+
+rmw_ret_t ConnextStaticPublisherInfo::wait_for_acknowledgments(const rmw_time_t & wait_timeout)
+{
+  DDS::ReturnCode_t status = data_writer_->wait_for_acknowledgments(
+    rmw_time_to_dds(wait_timeout));
+  if (DDS::RETCODE_TIMEOUT == status) {
+    return RMW_RET_TIMEOUT;
+  }
+  if (DDS::RETCODE_OK != status) {
+    RMW_SET_ERROR_MSG("failed to wait for acknowledgments");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t ConnextStaticPublisherInfo::shrink_serialization_buffer()
+{
+  std::lock_guard<std::mutex> lock(serialization_mutex_);
+  bool released = RCUTILS_RET_OK == rcutils_uint8_array_fini(&serialization_buffer_);
+  released = RCUTILS_RET_OK == rcutils_uint8_array_fini(&compression_buffer_) && released;
+  if (!released) {
+    RMW_SET_ERROR_MSG("failed to release serialization buffer");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
@@ -16,6 +16,8 @@
 #define CONNEXT_STATIC_PUBLISHER_INFO_HPP_
 
 #include <atomic>
+#include <cstdint>
+#include <mutex>
 
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
@@ -26,19 +28,219 @@
 
 #include "rosidl_typesupport_connext_cpp/message_type_support.h"
 
+#include "rcutils/types/uint8_array.h"
+
 #include "rmw/types.h"
 #include "rmw/ret_types.h"
 
+#include "loaned_message_pool.hpp"
+#include "message_type_info.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
 class ConnextPublisherListener;
 
+/// Storage reserved up front for publishing messages of a type, see rmw_init_publisher_allocation.
+struct ConnextStaticPublisherAllocation
+{
+  /// Type support callbacks of the message type the allocation was made for.
+  const message_type_support_callbacks_t * callbacks_;
+  /// Buffer messages are serialized into, sized for the largest expected message.
+  rcutils_uint8_array_t serialization_buffer_;
+};
+
+/// Running totals of a publisher's activity, see rmw_connext_cpp::get_publisher_statistics().
+/**
+ * Counters are only updated with relaxed atomic operations, so reading them concurrently
+ * with publishing gives a cheap, possibly slightly inconsistent, snapshot.
+ */
+struct ConnextPublisherCounters
+{
+  /// Messages successfully written.
+  std::atomic<uint64_t> published_messages{0};
+  /// Serialized bytes successfully written, encapsulation headers included, after compression.
+  std::atomic<uint64_t> published_bytes{0};
+  /// Time spent serializing messages, in nanoseconds.
+  std::atomic<uint64_t> serialization_time_ns{0};
+  /// Time spent compressing serialized messages, in nanoseconds.
+  std::atomic<uint64_t> compression_time_ns{0};
+  /// Time spent in DataWriter::write, in nanoseconds.
+  std::atomic<uint64_t> write_time_ns{0};
+  /// Writes that timed out or were refused because the writer had no room for the sample.
+  std::atomic<uint64_t> blocked_writes{0};
+  /// Publishes that failed for any other reason, whichever step failed.
+  std::atomic<uint64_t> failed_writes{0};
+
+  static void add(std::atomic<uint64_t> & counter, uint64_t value)
+  {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  }
+};
+
 struct ConnextStaticPublisherInfo : ConnextCustomEventInfo
 {
+  /// Publisher shared by all the publishers of the node, see get_node_publisher().
   DDS::Publisher * dds_publisher_;
   ConnextPublisherListener * listener_;
   DDS::DataWriter * topic_writer_;
+  /// The topic writer, narrowed once at creation to the serialized data type.
+  ConnextStaticSerializedDataDataWriter * data_writer_;
+  /// Sample reused for every write, guarded by serialization_mutex_.
+  /**
+   * Its serialized_data sequence only loans the buffer being published for the
+   * duration of a write.
+   */
+  ConnextStaticSerializedData * sample_;
   DDS::Topic * topic_;
   const message_type_support_callbacks_t * callbacks_;
   rmw_gid_t publisher_gid;
+  /// Properties of the published message type, computed once at creation.
+  MessageTypeInfo type_info_;
+  /// Buffer holding the serialized message, reused across publishes.
+  /**
+   * Its capacity only ever grows to the largest message seen so far, until it is
+   * explicitly released with shrink_serialization_buffer().
+   * Access must be guarded by serialization_mutex_.
+   */
+  rcutils_uint8_array_t serialization_buffer_;
+  std::mutex serialization_mutex_;
+  /// `true` if serialized messages are compressed before being written.
+  bool is_compression_enabled_;
+  /// Buffer holding the compressed message, reused across publishes.
+  /**
+   * Like serialization_buffer_, it only grows until shrink_serialization_buffer() is called
+   * and access must be guarded by serialization_mutex_.
+   */
+  rcutils_uint8_array_t compression_buffer_;
+  /// `true` if the data writer was created with DDS batching enabled.
+  bool is_batching_enabled_;
+  /// `true` if the data writer keeps all samples until they are acknowledged.
+  bool is_keep_all_;
+  /// Maximum number of samples in the data writer's history, or DDS::LENGTH_UNLIMITED.
+  DDS::Long max_samples_;
+  /// `true` if the data writer is reliable and limits the number of unacknowledged samples.
+  bool is_send_window_limited_;
+  /// Message memory loaned to the user, only enabled for plain message types.
+  LoanedMessagePool loan_pool_;
+  /// Statistics updated by publish() and write().
+  ConnextPublisherCounters counters_;
+
+  /// Maximum number of messages a publisher can have on loan at the same time.
+  static constexpr size_t max_loaned_messages = 16;
+
+  /// Serialize a ROS message into a buffer.
+  /**
+   * Messages whose in-memory representation matches their CDR encoding are copied
+   * as they are, without going through the type support.
+   * The buffer only grows when it is too small for the message.
+   * The time spent is added to counters_, a failure is counted by publish().
+   *
+   * \param ros_message the ROS message to serialize
+   * \param serialized_message the buffer to serialize into, usually serialization_buffer_
+   *   (then serialization_mutex_ must be held by the caller)
+   * \return `true` if the message was serialized, otherwise `false`
+   */
+  bool serialize(const void * ros_message, rcutils_uint8_array_t * serialized_message);
+
+  /// Same as serialize(), without updating counters_.
+  bool serialize_stream(const void * ros_message, rcutils_uint8_array_t * serialized_message);
+
+  /// Copy a CDR compatible ROS message into a buffer.
+  /**
+   * type_info_.is_cdr_compatible must be `true`.
+   *
+   * \param ros_message the ROS message to serialize
+   * \param serialized_message the buffer to copy into
+   * \return `true` if the message was serialized, otherwise `false`
+   */
+  bool serialize_plain(const void * ros_message, rcutils_uint8_array_t * serialized_message);
+
+  /// Serialize a ROS message and write it with the data writer.
+  /**
+   * serialization_mutex_ must be held by the caller.
+   * The outcome is added to counters_ once, whether serializing or writing failed.
+   *
+   * \param ros_message the ROS message to publish
+   * \param serialized_message the buffer to serialize into, see serialize()
+   * \return `true` if the message was written, otherwise `false`
+   */
+  bool publish(const void * ros_message, rcutils_uint8_array_t * serialized_message);
+
+  /// Write a serialized message with the data writer.
+  /**
+   * serialization_mutex_ must be held by the caller.
+   * The outcome and the time spent are added to counters_.
+   *
+   * \param cdr_stream the serialized message to write
+   * \return `true` if the message was written, otherwise `false`
+   */
+  bool write(const rcutils_uint8_array_t * cdr_stream);
+
+  /// Same as write(), without counting the outcome in counters_.
+  /**
+   * sample_ only borrows the buffer for the duration of the write.
+   * If compression is enabled, the message is compressed into compression_buffer_ first,
+   * unless that doesn't make it smaller.
+   *
+   * \param cdr_stream the serialized message to write
+   * \param written_length set to the number of bytes written, after compression
+   * \return the status of the write, `DDS::RETCODE_ERROR` if it could not be attempted
+   */
+  DDS::ReturnCode_t write_stream(
+    const rcutils_uint8_array_t * cdr_stream, size_t & written_length);
+
+  /// Add the outcome of a publish to counters_.
+  /**
+   * This is the only place publish outcomes are counted, so that each message is counted once.
+   *
+   * \param status the status of the publish
+   * \param written_length the number of bytes written, if successful
+   * \return `true` if the message was written, otherwise `false`
+   */
+  bool count_publish(DDS::ReturnCode_t status, size_t written_length);
+
+  /// Check if writing another sample would block the caller.
+  /**
+   * A write blocks when the history of a keep all writer is full, or when the send window
+   * of a reliable writer is full, until enough samples are acknowledged.
+   * Only writes can make these conditions worse, so the result stays valid until the next
+   * write as long as serialization_mutex_ is held.
+   *
+   * \param would_block set to `true` if a write would block
+   * \return `true` if the writer state could be checked, otherwise `false`
+   */
+  bool check_would_block(bool & would_block);
+
+  /// Block until all matched reliable readers acknowledged the samples written so far.
+  /**
+   * serialization_mutex_ must not be held, so that other threads can keep publishing.
+   *
+   * \param wait_timeout maximum time to wait, RMW_DURATION_INFINITE to wait forever
+   * \return `RMW_RET_OK` if all samples were acknowledged, or
+   * \return `RMW_RET_TIMEOUT` if the timeout expired first, or
+   * \return `RMW_RET_ERROR` if an unexpected error occurs
+   */
+  rmw_ret_t wait_for_acknowledgments(const rmw_time_t & wait_timeout);
+
+  /// Compress a serialized message into compression_buffer_.
+  /**
+   * serialization_mutex_ must be held by the caller.
+   * The time spent is added to counters_.
+   *
+   * \param cdr_stream the serialized message to compress
+   * \return the compressed message, or
+   * \return `nullptr` if the message should be written as it is
+   */
+  const rcutils_uint8_array_t * compress(const rcutils_uint8_array_t * cdr_stream);
+
+  /// Release the memory held by the serialization and compression buffers.
+  /**
+   * The next publish will allocate a buffer large enough for the message being published.
+   *
+   * \return `RMW_RET_OK` if successful, otherwise `RMW_RET_ERROR`
+   */
+  rmw_ret_t shrink_serialization_buffer();
 
   /**
    * Remap the specific RTI Connext DDS DataWriter Status to a generic RMW status type.
@@ -55,7 +257,7 @@ struct ConnextStaticPublisherInfo : ConnextCustomEventInfo
   DDS::Entity * get_entity() override;
 };
 
-class ConnextPublisherListener : public DDS::PublisherListener
+class ConnextPublisherListener : public DDS::DataWriterListener
 {
 public:
   virtual void on_publication_matched(
@@ -110,3 +110,42 @@ DDS::Entity * ConnextStaticSubscriberInfo::get_entity()
 {
   return topic_reader_;
 }
+
+ConnextSubscriptionLoan * ConnextStaticSubscriberInfo::find_loan(const void * message)
+{
+  for (ConnextSubscriptionLoan & loan : loans_) {
+    if (loan.message_ == message) {
+      return &loan;
+    }
+  }
+  return nullptr;
+}
+
+bool ConnextStaticSubscriberInfo::end_loan(ConnextSubscriptionLoan * loan)
+{
+  bool ended = true;
+  if (loan->is_sample_loan_) {
+    ConnextStaticSerializedDataDataReader * data_reader =
+      ConnextStaticSerializedDataDataReader::narrow(topic_reader_);
+    ended = data_reader &&
+      data_reader->return_loan(loan->dds_messages_, loan->sample_infos_) == DDS::RETCODE_OK;
+    --sample_loans_;
+  } else {
+    ended = loan_pool_.give_back(loan->message_);
+  }
+  loan->message_ = nullptr;
+  loan->is_sample_loan_ = false;
+  return ended;
+}
+
+bool ConnextStaticSubscriberInfo::end_all_loans()
+{
+  std::lock_guard<std::mutex> lock(loan_mutex_);
+  bool ended = true;
+  for (ConnextSubscriptionLoan & loan : loans_) {
+    if (loan.message_) {
+      ended = end_loan(&loan) && ended;
+    }
+  }
+  return ended;
+}
@@ -16,6 +16,8 @@
 #define CONNEXT_STATIC_SUBSCRIBER_INFO_HPP_
 
 #include <atomic>
+#include <cstddef>
+#include <mutex>
 
 #include "rmw_connext_shared_cpp/ndds_include.hpp"
 #include "rmw_connext_shared_cpp/connext_static_event_info.hpp"
@@ -25,19 +27,109 @@
 #include "ndds/ndds_namespace_cpp.h"
 
 #include "rosidl_typesupport_connext_cpp/message_type_support.h"
+#include "rcutils/types/uint8_array.h"
 #include "rmw/types.h"
 #include "rmw/ret_types.h"
 
+#include "loaned_message_pool.hpp"
+#include "message_type_info.hpp"
+
+// include patched generated code from the build folder
+#include "connext_static_serialized_dataSupport.h"
+
 class ConnextSubscriberListener;
 
+/// Storage reserved up front for taking messages of a type, see rmw_init_subscription_allocation.
+/**
+ * Messages are converted straight from the samples loaned by the data reader, so only
+ * compressed messages need memory of their own.
+ */
+struct ConnextStaticSubscriptionAllocation
+{
+  /// Type support callbacks of the message type the allocation was made for.
+  const message_type_support_callbacks_t * callbacks_;
+  /// Buffer compressed messages are restored into, sized for the largest expected message.
+  rcutils_uint8_array_t decompression_buffer_;
+};
+
+/// A message on loan to the user, see rmw_take_loaned_message.
+struct ConnextSubscriptionLoan
+{
+  /// The loaned ROS message, `nullptr` if this loan is unused.
+  void * message_;
+  /// `true` if message_ points into the sample still on loan from the data reader,
+  /// `false` if the message was converted into the subscription's loan_pool_.
+  bool is_sample_loan_;
+  /// The samples on loan from the data reader, if is_sample_loan_ is `true`.
+  ConnextStaticSerializedDataSeq dds_messages_;
+  DDS::SampleInfoSeq sample_infos_;
+};
+
 struct ConnextStaticSubscriberInfo : ConnextCustomEventInfo
 {
+  /// Maximum number of messages a subscription can have on loan at the same time.
+  static constexpr size_t max_loaned_messages = 16;
+  /// Size of the GUID prefix, which identifies the participant of an entity.
+  static constexpr size_t guid_prefix_size = 12;
+
+  /// Subscriber shared by all the subscriptions of the node, see get_node_subscriber().
   DDS::Subscriber * dds_subscriber_;
   ConnextSubscriberListener * listener_;
   DDS::DataReader * topic_reader_;
   DDS::Topic * topic_;
   DDS::ReadCondition * read_condition_;
   const message_type_support_callbacks_t * callbacks_;
+  /// GUID prefix of the data reader, shared by all the writers of its participant.
+  /**
+   * Computed once at creation, so that local publications can be ignored without
+   * querying the data reader for every sample.
+   */
+  DDS::Octet guid_prefix_[guid_prefix_size];
+  /// Properties of the subscribed message type, computed once at creation.
+  MessageTypeInfo type_info_;
+  /// `true` if received messages may be compressed, see rmw_connext_shared_cpp/compression.hpp.
+  /**
+   * Only set for topics listed in `RMW_CONNEXT_COMPRESSED_TOPICS`, so that messages of other
+   * topics are never mistaken for compressed ones.
+   */
+  bool is_compression_enabled_;
+  /// Messages on loan to the user, guarded by loan_mutex_.
+  ConnextSubscriptionLoan loans_[max_loaned_messages];
+  /// Number of loans in loans_ that hold a sample of the data reader.
+  size_t sample_loans_;
+  /// Maximum number of samples that can be held on loan.
+  /**
+   * Samples on loan stay in the data reader history, so this leaves room in the history
+   * for new samples; other loans are converted into loan_pool_ instead.
+   */
+  size_t max_sample_loans_;
+  /// Memory for loaned messages that are not handed out from the sample itself.
+  LoanedMessagePool loan_pool_;
+  std::mutex loan_mutex_;
+
+  /// Find the loan of a message.
+  /**
+   * loan_mutex_ must be held by the caller.
+   *
+   * \param message the loaned message, or `nullptr` to find an unused loan
+   * \return the loan, or `nullptr` if there is none
+   */
+  ConnextSubscriptionLoan * find_loan(const void * message);
+
+  /// End a loan, giving the sample back to the data reader or the memory back to loan_pool_.
+  /**
+   * loan_mutex_ must be held by the caller.
+   *
+   * \return `true` if successful, otherwise `false`
+   */
+  bool end_loan(ConnextSubscriptionLoan * loan);
+
+  /// End all loans, the data reader can only be deleted once none of its samples is on loan.
+  /**
+   * \return `true` if successful, otherwise `false`
+   */
+  bool end_all_loans();
+
   /// Remap the specific RTI Connext DDS DataReader Status to a generic RMW status type.
   /**
    * \param mask input status mask
@@ -51,7 +143,7 @@ struct ConnextStaticSubscriberInfo : ConnextCustomEventInfo
   DDS::Entity * get_entity() override;
 };
 
-class ConnextSubscriberListener : public DDS::SubscriberListener
+class ConnextSubscriberListener : public DDS::DataReaderListener
 {
 public:
   virtual void on_subscription_matched(
@@ -0,0 +1,89 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "loaned_message_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "rmw/allocators.h"
+
+LoanedMessagePool::~LoanedMessagePool()
+{
+  for (void * message : free_) {
+    rmw_free(message);
+  }
+  for (void * message : loaned_) {
+    rmw_free(message);
+  }
+}
+
+bool
+LoanedMessagePool::init(size_t message_size, size_t max_loans)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  try {
+    // reserve upfront, so that borrowing and giving back never reallocates
+    free_.reserve(max_loans);
+    loaned_.reserve(max_loans);
+  } catch (const std::bad_alloc &) {
+    return false;
+  }
+  message_size_ = message_size;
+  max_loans_ = max_loans;
+  return true;
+}
+
+void *
+LoanedMessagePool::borrow()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (loaned_.size() >= max_loans_) {
+    return nullptr;
+  }
+  void * message = nullptr;
+  if (!free_.empty()) {
+    message = free_.back();
+    free_.pop_back();
+  } else {
+    message = rmw_allocate(message_size_);
+    if (!message) {
+      return nullptr;
+    }
+    memset(message, 0, message_size_);
+  }
+  loaned_.push_back(message);
+  return message;
+}
+
+bool
+LoanedMessagePool::is_loaned(const void * message)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::find(loaned_.begin(), loaned_.end(), message) != loaned_.end();
+}
+
+bool
+LoanedMessagePool::give_back(void * message)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find(loaned_.begin(), loaned_.end(), message);
+  if (it == loaned_.end()) {
+    return false;
+  }
+  loaned_.erase(it);
+  free_.push_back(message);
+  return true;
+}
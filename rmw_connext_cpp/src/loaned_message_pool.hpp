@@ -0,0 +1,78 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOANED_MESSAGE_POOL_HPP_
+#define LOANED_MESSAGE_POOL_HPP_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/// Pool of fixed-size message buffers handed out as loans.
+/**
+ * Buffers are allocated lazily and kept for reuse once given back, so a pool
+ * that reached its working set does not allocate anymore.
+ * At most `max_loans` buffers can be on loan at the same time.
+ */
+class LoanedMessagePool
+{
+public:
+  LoanedMessagePool() = default;
+
+  LoanedMessagePool(const LoanedMessagePool &) = delete;
+  LoanedMessagePool & operator=(const LoanedMessagePool &) = delete;
+
+  ~LoanedMessagePool();
+
+  /// Enable the pool for messages of the given size.
+  /**
+   * \return `false` if memory for the bookkeeping could not be allocated
+   */
+  bool
+  init(size_t message_size, size_t max_loans);
+
+  /// Return `true` if the pool was initialized.
+  bool
+  is_enabled() const
+  {
+    return message_size_ != 0;
+  }
+
+  /// Loan a buffer, or return `nullptr` if none is available.
+  /**
+   * Newly allocated buffers are zero initialized, reused ones keep their content.
+   */
+  void *
+  borrow();
+
+  /// Return `true` if the buffer is currently on loan from this pool.
+  bool
+  is_loaned(const void * message);
+
+  /// Give back a loaned buffer.
+  /**
+   * \return `false` if the buffer is not on loan from this pool
+   */
+  bool
+  give_back(void * message);
+
+private:
+  std::mutex mutex_;
+  size_t message_size_{0};
+  size_t max_loans_{0};
+  std::vector<void *> free_;
+  std::vector<void *> loaned_;
+};
+
+#endif  // LOANED_MESSAGE_POOL_HPP_
@@ -0,0 +1,496 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "message_type_info.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "rmw/error_handling.h"
+
+namespace
+{
+
+size_t
+align_to(size_t offset, size_t alignment)
+{
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+/// Compute the layout a plain ROS message member has in memory.
+/**
+ * Primitives map to the same-width C/C++ types used by the ROS type supports,
+ * structures follow the natural alignment rules of the compiler.
+ * `is_plain` is set to `false` as soon as a string or sequence is found.
+ */
+bool
+get_plain_layout(
+  const DDS::TypeCode * type_code, bool & is_plain, size_t & size, size_t & alignment)
+{
+  DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+  DDS_TCKind kind = type_code->kind(ex);
+  if (ex != DDS_NO_EXCEPTION_CODE) {
+    RMW_SET_ERROR_MSG("failed to get type code kind");
+    return false;
+  }
+
+  switch (kind) {
+    case DDS_TK_BOOLEAN:
+    case DDS_TK_CHAR:
+    case DDS_TK_OCTET:
+      size = alignment = 1;
+      return true;
+    case DDS_TK_SHORT:
+    case DDS_TK_USHORT:
+    // ROS represents wide characters as 16 bit integers
+    case DDS_TK_WCHAR:
+      size = alignment = 2;
+      return true;
+    case DDS_TK_LONG:
+    case DDS_TK_ULONG:
+    case DDS_TK_FLOAT:
+    case DDS_TK_ENUM:
+      size = alignment = 4;
+      return true;
+    case DDS_TK_LONGLONG:
+    case DDS_TK_ULONGLONG:
+    case DDS_TK_DOUBLE:
+      size = alignment = 8;
+      return true;
+    case DDS_TK_LONGDOUBLE:
+      size = sizeof(long double);
+      alignment = alignof(long double);
+      return true;
+    case DDS_TK_ALIAS:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get aliased type code");
+          return false;
+        }
+        return get_plain_layout(content_type, is_plain, size, alignment);
+      }
+    case DDS_TK_ARRAY:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get array element type code");
+          return false;
+        }
+        DDS_UnsignedLong element_count = type_code->element_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get array element count");
+          return false;
+        }
+        if (!get_plain_layout(content_type, is_plain, size, alignment)) {
+          return false;
+        }
+        size *= element_count;
+        return true;
+      }
+    case DDS_TK_STRUCT:
+      {
+        DDS_UnsignedLong member_count = type_code->member_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get structure member count");
+          return false;
+        }
+        size_t offset = 0;
+        alignment = 1;
+        for (DDS_UnsignedLong i = 0; i < member_count && is_plain; ++i) {
+          const DDS::TypeCode * member_type = type_code->member_type(i, ex);
+          if (ex != DDS_NO_EXCEPTION_CODE || !member_type) {
+            RMW_SET_ERROR_MSG("failed to get structure member type code");
+            return false;
+          }
+          size_t member_size = 0;
+          size_t member_alignment = 1;
+          if (!get_plain_layout(member_type, is_plain, member_size, member_alignment)) {
+            return false;
+          }
+          offset = align_to(offset, member_alignment) + member_size;
+          if (member_alignment > alignment) {
+            alignment = member_alignment;
+          }
+        }
+        size = align_to(offset, alignment);
+        return true;
+      }
+    default:
+      // strings, sequences and anything ROS does not generate own memory
+      is_plain = false;
+      size = 0;
+      alignment = 1;
+      return true;
+  }
+}
+
+/// Lay out a plain ROS message member in memory and in CDR at the same time.
+/**
+ * `memory_offset` and `cdr_offset` are advanced past the member.
+ * `is_compatible` is set to `false` as soon as a primitive ends up at a different
+ * offset in both representations, or has a different width in CDR than in memory.
+ */
+bool
+get_cdr_layout(
+  const DDS::TypeCode * type_code,
+  size_t & memory_offset,
+  size_t & cdr_offset,
+  bool & is_compatible)
+{
+  DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+  DDS_TCKind kind = type_code->kind(ex);
+  if (ex != DDS_NO_EXCEPTION_CODE) {
+    RMW_SET_ERROR_MSG("failed to get type code kind");
+    return false;
+  }
+
+  size_t primitive_size = 0;
+  switch (kind) {
+    case DDS_TK_BOOLEAN:
+    case DDS_TK_CHAR:
+    case DDS_TK_OCTET:
+      primitive_size = 1;
+      break;
+    case DDS_TK_SHORT:
+    case DDS_TK_USHORT:
+      primitive_size = 2;
+      break;
+    case DDS_TK_LONG:
+    case DDS_TK_ULONG:
+    case DDS_TK_FLOAT:
+    case DDS_TK_ENUM:
+      primitive_size = 4;
+      break;
+    case DDS_TK_LONGLONG:
+    case DDS_TK_ULONGLONG:
+    case DDS_TK_DOUBLE:
+      primitive_size = 8;
+      break;
+    case DDS_TK_ALIAS:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get aliased type code");
+          return false;
+        }
+        return get_cdr_layout(content_type, memory_offset, cdr_offset, is_compatible);
+      }
+    case DDS_TK_ARRAY:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get array element type code");
+          return false;
+        }
+        DDS_UnsignedLong element_count = type_code->element_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get array element count");
+          return false;
+        }
+        bool is_plain = true;
+        size_t element_size = 0;
+        size_t element_alignment = 1;
+        if (!get_plain_layout(content_type, is_plain, element_size, element_alignment)) {
+          return false;
+        }
+        for (DDS_UnsignedLong i = 0; i < element_count && is_compatible; ++i) {
+          size_t element_cdr_start = cdr_offset;
+          if (!get_cdr_layout(content_type, memory_offset, cdr_offset, is_compatible)) {
+            return false;
+          }
+          if (is_compatible && cdr_offset - element_cdr_start == element_size) {
+            // every following element is laid out exactly like this one
+            memory_offset += (element_count - i - 1) * element_size;
+            cdr_offset += (element_count - i - 1) * element_size;
+            break;
+          }
+        }
+        return true;
+      }
+    case DDS_TK_STRUCT:
+      {
+        bool is_plain = true;
+        size_t size = 0;
+        size_t alignment = 1;
+        if (!get_plain_layout(type_code, is_plain, size, alignment)) {
+          return false;
+        }
+        DDS_UnsignedLong member_count = type_code->member_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get structure member count");
+          return false;
+        }
+        // CDR does not align structures themselves, only their primitive members
+        memory_offset = align_to(memory_offset, alignment);
+        for (DDS_UnsignedLong i = 0; i < member_count && is_compatible; ++i) {
+          const DDS::TypeCode * member_type = type_code->member_type(i, ex);
+          if (ex != DDS_NO_EXCEPTION_CODE || !member_type) {
+            RMW_SET_ERROR_MSG("failed to get structure member type code");
+            return false;
+          }
+          if (!get_cdr_layout(member_type, memory_offset, cdr_offset, is_compatible)) {
+            return false;
+          }
+        }
+        memory_offset = align_to(memory_offset, alignment);
+        return true;
+      }
+    default:
+      // wide characters and long doubles have a different width in CDR
+      is_compatible = false;
+      return true;
+  }
+
+  memory_offset = align_to(memory_offset, primitive_size);
+  cdr_offset = align_to(cdr_offset, primitive_size);
+  if (memory_offset != cdr_offset) {
+    is_compatible = false;
+  }
+  memory_offset += primitive_size;
+  cdr_offset += primitive_size;
+  return true;
+}
+
+/// Return `true` if a string or sequence length in a type code means "unbounded".
+bool
+is_unbounded_length(DDS_UnsignedLong length)
+{
+  return 0 == length ||
+         length >= static_cast<DDS_UnsignedLong>(std::numeric_limits<DDS_Long>::max());
+}
+
+/// Advance `offset` past the largest CDR encoding of a message member.
+/**
+ * Unbounded strings and sequences are counted as empty and clear `is_bounded`.
+ */
+bool
+get_max_serialized_size(const DDS::TypeCode * type_code, size_t & offset, bool & is_bounded)
+{
+  DDS_ExceptionCode_t ex = DDS_NO_EXCEPTION_CODE;
+  DDS_TCKind kind = type_code->kind(ex);
+  if (ex != DDS_NO_EXCEPTION_CODE) {
+    RMW_SET_ERROR_MSG("failed to get type code kind");
+    return false;
+  }
+
+  switch (kind) {
+    case DDS_TK_BOOLEAN:
+    case DDS_TK_CHAR:
+    case DDS_TK_OCTET:
+      offset += 1;
+      return true;
+    case DDS_TK_SHORT:
+    case DDS_TK_USHORT:
+      offset = align_to(offset, 2) + 2;
+      return true;
+    case DDS_TK_LONG:
+    case DDS_TK_ULONG:
+    case DDS_TK_FLOAT:
+    case DDS_TK_ENUM:
+    case DDS_TK_WCHAR:
+      offset = align_to(offset, 4) + 4;
+      return true;
+    case DDS_TK_LONGLONG:
+    case DDS_TK_ULONGLONG:
+    case DDS_TK_DOUBLE:
+      offset = align_to(offset, 8) + 8;
+      return true;
+    case DDS_TK_LONGDOUBLE:
+      offset = align_to(offset, 8) + 16;
+      return true;
+    case DDS_TK_STRING:
+    case DDS_TK_WSTRING:
+      {
+        DDS_UnsignedLong length = type_code->length(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get string bound");
+          return false;
+        }
+        if (is_unbounded_length(length)) {
+          is_bounded = false;
+          length = 0;
+        }
+        // length prefix, characters and the terminating null character
+        const size_t character_size = DDS_TK_STRING == kind ? 1 : 4;
+        offset = align_to(offset, 4) + 4 + (length + 1) * character_size;
+        return true;
+      }
+    case DDS_TK_ALIAS:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get aliased type code");
+          return false;
+        }
+        return get_max_serialized_size(content_type, offset, is_bounded);
+      }
+    case DDS_TK_ARRAY:
+    case DDS_TK_SEQUENCE:
+      {
+        const DDS::TypeCode * content_type = type_code->content_type(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE || !content_type) {
+          RMW_SET_ERROR_MSG("failed to get element type code");
+          return false;
+        }
+        DDS_UnsignedLong element_count = 0;
+        if (DDS_TK_ARRAY == kind) {
+          element_count = type_code->element_count(ex);
+        } else {
+          element_count = type_code->length(ex);
+        }
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get element count");
+          return false;
+        }
+        if (DDS_TK_SEQUENCE == kind) {
+          offset = align_to(offset, 4) + 4;
+          if (is_unbounded_length(element_count)) {
+            is_bounded = false;
+            return true;
+          }
+        }
+        // The size of an element only depends on where it starts modulo the largest
+        // alignment, so the layout repeats as soon as such a start is seen again.
+        constexpr size_t max_alignment = 8;
+        size_t seen_index[max_alignment];
+        size_t seen_offset[max_alignment];
+        bool seen[max_alignment] = {};
+        for (size_t i = 0; i < element_count; ++i) {
+          const size_t phase = offset % max_alignment;
+          if (seen[phase]) {
+            const size_t period = i - seen_index[phase];
+            const size_t repetitions = (element_count - i) / period;
+            offset += repetitions * (offset - seen_offset[phase]);
+            i += repetitions * period;
+            std::fill(seen, seen + max_alignment, false);
+            if (i >= element_count) {
+              break;
+            }
+          }
+          seen[phase] = true;
+          seen_index[phase] = i;
+          seen_offset[phase] = offset;
+          if (!get_max_serialized_size(content_type, offset, is_bounded)) {
+            return false;
+          }
+        }
+        return true;
+      }
+    case DDS_TK_STRUCT:
+      {
+        DDS_UnsignedLong member_count = type_code->member_count(ex);
+        if (ex != DDS_NO_EXCEPTION_CODE) {
+          RMW_SET_ERROR_MSG("failed to get structure member count");
+          return false;
+        }
+        for (DDS_UnsignedLong i = 0; i < member_count; ++i) {
+          const DDS::TypeCode * member_type = type_code->member_type(i, ex);
+          if (ex != DDS_NO_EXCEPTION_CODE || !member_type) {
+            RMW_SET_ERROR_MSG("failed to get structure member type code");
+            return false;
+          }
+          if (!get_max_serialized_size(member_type, offset, is_bounded)) {
+            return false;
+          }
+        }
+        return true;
+      }
+    default:
+      RMW_SET_ERROR_MSG("unsupported type code kind");
+      return false;
+  }
+}
+
+}  // namespace
+
+bool
+get_message_type_info(const DDS::TypeCode * type_code, MessageTypeInfo & info)
+{
+  if (!type_code) {
+    RMW_SET_ERROR_MSG("type code handle is null");
+    return false;
+  }
+  info.is_plain = true;
+  info.plain_size = 0;
+  info.plain_alignment = 1;
+  if (!get_plain_layout(type_code, info.is_plain, info.plain_size, info.plain_alignment)) {
+    return false;
+  }
+  if (!info.is_plain) {
+    info.plain_size = 0;
+    info.plain_alignment = 1;
+  }
+  info.is_cdr_compatible = info.is_plain;
+  info.cdr_size = 0;
+  if (info.is_cdr_compatible) {
+    size_t memory_offset = 0;
+    if (!get_cdr_layout(type_code, memory_offset, info.cdr_size, info.is_cdr_compatible)) {
+      return false;
+    }
+  }
+  if (!info.is_cdr_compatible) {
+    info.cdr_size = 0;
+  }
+  // alignment is relative to the end of the 4 byte encapsulation header
+  info.is_bounded = true;
+  info.max_serialized_size = 0;
+  if (!get_max_serialized_size(type_code, info.max_serialized_size, info.is_bounded)) {
+    return false;
+  }
+  // the type support pads the payload to a multiple of 4 bytes, after the 4 byte header
+  info.max_serialized_size += 4 + (4 - info.max_serialized_size % 4) % 4;
+  return true;
+}
+
+const MessageTypeInfo *
+get_cached_message_type_info(const message_type_support_callbacks_t * callbacks)
+{
+  static std::mutex cache_mutex;
+  static std::unordered_map<const message_type_support_callbacks_t *, MessageTypeInfo> cache;
+
+  if (!callbacks) {
+    RMW_SET_ERROR_MSG("callbacks handle is null");
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  auto it = cache.find(callbacks);
+  if (it != cache.end()) {
+    return &it->second;
+  }
+  const DDS::TypeCode * type_code = callbacks->get_type_code();
+  if (!type_code) {
+    RMW_SET_ERROR_MSG("failed to fetch type code");
+    return nullptr;
+  }
+  MessageTypeInfo info;
+  if (!get_message_type_info(type_code, info)) {
+    return nullptr;
+  }
+  // references to elements of an unordered_map stay valid when it grows
+  return &cache.emplace(callbacks, info).first->second;
+}
+
+bool
+is_host_little_endian()
+{
+  const uint16_t probe = 1;
+  uint8_t first_byte = 0;
+  memcpy(&first_byte, &probe, 1);
+  return 1 == first_byte;
+}
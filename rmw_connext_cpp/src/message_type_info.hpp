@@ -0,0 +1,88 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MESSAGE_TYPE_INFO_HPP_
+#define MESSAGE_TYPE_INFO_HPP_
+
+#include <cstddef>
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+#include "rosidl_typesupport_connext_cpp/message_type_support.h"
+
+/// Properties of a ROS message type, derived from its Connext type code.
+struct MessageTypeInfo
+{
+  /// `true` if the message only contains primitives, fixed-size arrays and nested such types.
+  /**
+   * The in-memory representation of such a message is the same for the C and C++
+   * type supports and it does not own any memory, so it can be handed out as a loan.
+   */
+  bool is_plain;
+  /// Size of the ROS message in memory, only meaningful if is_plain is `true`.
+  size_t plain_size;
+  /// Alignment of the ROS message in memory, only meaningful if is_plain is `true`.
+  size_t plain_alignment;
+  /// `true` if the in-memory representation of a plain message matches its CDR encoding.
+  /**
+   * The bytes of such a message, in host byte order, can be used as serialized data
+   * without going through the type support.
+   * Padding between members is allowed as long as CDR aligns the member the same way.
+   */
+  bool is_cdr_compatible;
+  /// Size of the CDR encoding of the message, excluding the encapsulation header.
+  /**
+   * Only meaningful if is_cdr_compatible is `true`.
+   * It does not include the trailing padding of the in-memory representation.
+   */
+  size_t cdr_size;
+  /// `false` if the message contains any unbounded string or sequence.
+  bool is_bounded;
+  /// Size of the largest serialized message, encapsulation header and trailing padding included.
+  /**
+   * Only meaningful if is_bounded is `true`.
+   */
+  size_t max_serialized_size;
+};
+
+/// Size of the CDR encapsulation header preceding the serialized data.
+constexpr size_t encapsulation_header_size = 4;
+
+/// Return `true` if the host stores integers in little endian byte order.
+bool
+is_host_little_endian();
+
+/// Compute the properties of a ROS message type from its type code.
+/**
+ * \param[in] type_code the type code of the message, as returned by the type support
+ * \param[out] info the computed properties
+ * \return `true` if successful, or
+ * \return `false` if the type code could not be inspected, the error string is set
+ */
+bool
+get_message_type_info(const DDS::TypeCode * type_code, MessageTypeInfo & info);
+
+/// Get the properties of the message type of the given type support.
+/**
+ * The properties are computed on first use and cached for the lifetime of the process,
+ * so that subsequent lookups don't need to walk the type code again.
+ *
+ * \param[in] callbacks the type support callbacks of the message type
+ * \return the properties of the message type, or
+ * \return `nullptr` if they could not be computed, the error string is set
+ */
+const MessageTypeInfo *
+get_cached_message_type_info(const message_type_support_callbacks_t * callbacks);
+
+#endif  // MESSAGE_TYPE_INFO_HPP_
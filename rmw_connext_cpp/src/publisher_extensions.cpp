@@ -0,0 +1,315 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rmw_connext_cpp/publisher_extensions.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#include "rmw/error_handling.h"
+#include "rmw/impl/cpp/macros.hpp"
+
+#include "rmw_connext_cpp/identifier.hpp"
+#include "connext_static_publisher_info.hpp"
+
+namespace rmw_connext_cpp
+{
+
+rmw_ret_t
+shrink_publisher_serialization_buffer(rmw_publisher_t * publisher)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  return info->shrink_serialization_buffer();
+}
+
+rmw_ret_t
+get_publisher_statistics(const rmw_publisher_t * publisher, PublisherStatistics * statistics)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(statistics, RMW_RET_INVALID_ARGUMENT);
+
+  auto info = static_cast<const ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  const ConnextPublisherCounters & counters = info->counters_;
+  statistics->published_messages = counters.published_messages.load(std::memory_order_relaxed);
+  statistics->published_bytes = counters.published_bytes.load(std::memory_order_relaxed);
+  statistics->serialization_time_ns =
+    counters.serialization_time_ns.load(std::memory_order_relaxed);
+  statistics->compression_time_ns = counters.compression_time_ns.load(std::memory_order_relaxed);
+  statistics->write_time_ns = counters.write_time_ns.load(std::memory_order_relaxed);
+  statistics->blocked_writes = counters.blocked_writes.load(std::memory_order_relaxed);
+  statistics->failed_writes = counters.failed_writes.load(std::memory_order_relaxed);
+  return RMW_RET_OK;
+}
+
+namespace
+{
+
+ConnextStaticPublisherInfo *
+get_publisher_info_for_batch(const rmw_publisher_t * publisher, size_t * published_count)
+{
+  if (published_count) {
+    *published_count = 0;
+  }
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return nullptr;
+  }
+  if (!info->data_writer_) {
+    RMW_SET_ERROR_MSG("data writer handle is null");
+    return nullptr;
+  }
+  return info;
+}
+
+/// Send out what the data writer batched so far, if batching is enabled.
+bool
+flush_batch(ConnextStaticPublisherInfo * info)
+{
+  if (!info->is_batching_enabled_) {
+    return true;
+  }
+  return DDS::RETCODE_OK == info->data_writer_->flush();
+}
+
+/// Concatenate segments into a buffer, growing it only when it is too small.
+rmw_ret_t
+gather_segments(
+  const SerializedSegment * segments, size_t count, rcutils_uint8_array_t * buffer)
+{
+  size_t length = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (!segments[i].data && segments[i].length > 0) {
+      RMW_SET_ERROR_MSG("segment data handle is null");
+      return RMW_RET_INVALID_ARGUMENT;
+    }
+    if (segments[i].length > (std::numeric_limits<size_t>::max)() - length) {
+      RMW_SET_ERROR_MSG("serialized message length overflows");
+      return RMW_RET_INVALID_ARGUMENT;
+    }
+    length += segments[i].length;
+  }
+  if (0 == length) {
+    RMW_SET_ERROR_MSG("serialized message is empty");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (buffer->buffer_capacity < length) {
+    if (RCUTILS_RET_OK != rcutils_uint8_array_resize(buffer, length)) {
+      RMW_SET_ERROR_MSG("failed to resize serialization buffer");
+      return RMW_RET_ERROR;
+    }
+  }
+  uint8_t * position = buffer->buffer;
+  for (size_t i = 0; i < count; ++i) {
+    if (segments[i].length > 0) {
+      memcpy(position, segments[i].data, segments[i].length);
+      position += segments[i].length;
+    }
+  }
+  buffer->buffer_length = length;
+  return RMW_RET_OK;
+}
+
+}  // namespace
+
+rmw_ret_t
+publish_batch(
+  const rmw_publisher_t * publisher,
+  const void * const * ros_messages,
+  size_t count,
+  size_t * published_count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_messages, RMW_RET_INVALID_ARGUMENT);
+
+  ConnextStaticPublisherInfo * info = get_publisher_info_for_batch(publisher, published_count);
+  if (!info) {
+    return RMW_RET_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(info->serialization_mutex_);
+  rmw_ret_t ret = RMW_RET_OK;
+  size_t i = 0;
+  for (; i < count; ++i) {
+    if (!ros_messages[i]) {
+      RMW_SET_ERROR_MSG("ros message handle is null");
+      ret = RMW_RET_INVALID_ARGUMENT;
+      break;
+    }
+    if (!info->publish(ros_messages[i], &info->serialization_buffer_)) {
+      RMW_SET_ERROR_MSG("failed to publish message");
+      ret = RMW_RET_ERROR;
+      break;
+    }
+  }
+  // flush what was written even if a message failed
+  if (i > 0 && !flush_batch(info) && RMW_RET_OK == ret) {
+    RMW_SET_ERROR_MSG("failed to flush batch");
+    ret = RMW_RET_ERROR;
+  }
+  if (published_count) {
+    *published_count = i;
+  }
+  return ret;
+}
+
+rmw_ret_t
+publish_serialized_batch(
+  const rmw_publisher_t * publisher,
+  const rmw_serialized_message_t * serialized_messages,
+  size_t count,
+  size_t * published_count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(serialized_messages, RMW_RET_INVALID_ARGUMENT);
+
+  ConnextStaticPublisherInfo * info = get_publisher_info_for_batch(publisher, published_count);
+  if (!info) {
+    return RMW_RET_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(info->serialization_mutex_);
+  rmw_ret_t ret = RMW_RET_OK;
+  size_t i = 0;
+  for (; i < count; ++i) {
+    if (!serialized_messages[i].buffer || 0 == serialized_messages[i].buffer_length) {
+      RMW_SET_ERROR_MSG("serialized message is empty");
+      ret = RMW_RET_INVALID_ARGUMENT;
+      break;
+    }
+    if (!info->write(&serialized_messages[i])) {
+      RMW_SET_ERROR_MSG("failed to publish message");
+      ret = RMW_RET_ERROR;
+      break;
+    }
+  }
+  // flush what was written even if a message failed
+  if (i > 0 && !flush_batch(info) && RMW_RET_OK == ret) {
+    RMW_SET_ERROR_MSG("failed to flush batch");
+    ret = RMW_RET_ERROR;
+  }
+  if (published_count) {
+    *published_count = i;
+  }
+  return ret;
+}
+
+rmw_ret_t
+publish_serialized_segments(
+  const rmw_publisher_t * publisher,
+  const SerializedSegment * segments,
+  size_t count)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(segments, RMW_RET_INVALID_ARGUMENT);
+
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!info->data_writer_) {
+    RMW_SET_ERROR_MSG("data writer handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(info->serialization_mutex_);
+  rmw_ret_t ret = gather_segments(segments, count, &info->serialization_buffer_);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
+  if (!info->write(&info->serialization_buffer_)) {
+    RMW_SET_ERROR_MSG("failed to publish message");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+rmw_ret_t
+publish_nonblocking(const rmw_publisher_t * publisher, const void * ros_message)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_message, RMW_RET_INVALID_ARGUMENT);
+
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!info->data_writer_) {
+    RMW_SET_ERROR_MSG("data writer handle is null");
+    return RMW_RET_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(info->serialization_mutex_);
+  bool would_block = false;
+  if (!info->check_would_block(would_block)) {
+    // error string was set within the function
+    return RMW_RET_ERROR;
+  }
+  if (would_block) {
+    ConnextPublisherCounters::add(info->counters_.blocked_writes, 1);
+    return ret_would_block;
+  }
+  if (!info->publish(ros_message, &info->serialization_buffer_)) {
+    RMW_SET_ERROR_MSG("failed to publish message");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
+}
+
+}  // namespace rmw_connext_cpp
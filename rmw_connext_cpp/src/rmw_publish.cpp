@@ -12,7 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <limits>
+#include <mutex>
 
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
@@ -22,53 +22,36 @@
 #include "rmw_connext_cpp/identifier.hpp"
 #include "connext_static_publisher_info.hpp"
 
-// include patched generated code from the build folder
-#include "connext_static_serialized_dataSupport.h"
-
-bool
-publish(DDS::DataWriter * dds_data_writer, const rcutils_uint8_array_t * cdr_stream)
+/// Get the publisher allocation passed to a publish, if any.
+/**
+ * \return `RMW_RET_OK` if `allocation` is null or was made for the message type, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if it was made by another implementation, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if it is invalid or made for another message type
+ */
+static rmw_ret_t
+get_publisher_allocation(
+  rmw_publisher_allocation_t * allocation,
+  const message_type_support_callbacks_t * callbacks,
+  ConnextStaticPublisherAllocation ** publisher_allocation)
 {
-  ConnextStaticSerializedDataDataWriter * data_writer =
-    ConnextStaticSerializedDataDataWriter::narrow(dds_data_writer);
-  if (!data_writer) {
-    RMW_SET_ERROR_MSG("failed to narrow data writer");
-    return false;
-  }
-
-  ConnextStaticSerializedData * instance = ConnextStaticSerializedDataTypeSupport::create_data();
-  if (!instance) {
-    RMW_SET_ERROR_MSG("failed to create dds message instance");
-    return false;
+  *publisher_allocation = nullptr;
+  if (!allocation) {
+    return RMW_RET_OK;
   }
-
-  DDS::ReturnCode_t status = DDS::RETCODE_ERROR;
-
-  instance->serialized_data.maximum(0);
-  if (cdr_stream->buffer_length > static_cast<size_t>((std::numeric_limits<DDS_Long>::max)())) {
-    RMW_SET_ERROR_MSG("cdr_stream->buffer_length unexpectedly larger than DDS_Long's max value");
-    return false;
-  }
-  if (!instance->serialized_data.loan_contiguous(
-      reinterpret_cast<DDS::Octet *>(cdr_stream->buffer),
-      static_cast<DDS::Long>(cdr_stream->buffer_length),
-      static_cast<DDS::Long>(cdr_stream->buffer_length)))
-  {
-    RMW_SET_ERROR_MSG("failed to loan memory for message");
-    goto cleanup;
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    allocation, allocation->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  auto result = static_cast<ConnextStaticPublisherAllocation *>(allocation->data);
+  if (!result) {
+    RMW_SET_ERROR_MSG("publisher allocation is null");
+    return RMW_RET_INVALID_ARGUMENT;
   }
-
-  status = data_writer->write(*instance, DDS::HANDLE_NIL);
-
-cleanup:
-  if (instance) {
-    if (!instance->serialized_data.unloan()) {
-      fprintf(stderr, "failed to return loaned memory\n");
-      status = DDS::RETCODE_ERROR;
-    }
-    ConnextStaticSerializedDataTypeSupport::delete_data(instance);
+  if (result->callbacks_ != callbacks) {
+    RMW_SET_ERROR_MSG("publisher allocation was made for a different message type");
+    return RMW_RET_INVALID_ARGUMENT;
   }
-
-  return status == DDS::RETCODE_OK;
+  *publisher_allocation = result;
+  return RMW_RET_OK;
 }
 
 extern "C"
@@ -79,7 +62,6 @@ rmw_publish(
   const void * ros_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void) allocation;
   RMW_CHECK_FOR_NULL_WITH_MSG(
     publisher, "publisher handle is null",
     return RMW_RET_INVALID_ARGUMENT);
@@ -101,40 +83,28 @@ rmw_publish(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return RMW_RET_ERROR;
   }
-  DDS::DataWriter * topic_writer = publisher_info->topic_writer_;
-  if (!topic_writer) {
-    RMW_SET_ERROR_MSG("topic writer handle is null");
+  if (!publisher_info->data_writer_) {
+    RMW_SET_ERROR_MSG("data writer handle is null");
     return RMW_RET_ERROR;
   }
 
-  auto ret = RMW_RET_OK;
-  rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
-  cdr_stream.allocator = rcutils_get_default_allocator();
+  ConnextStaticPublisherAllocation * publisher_allocation = nullptr;
+  rmw_ret_t ret = get_publisher_allocation(allocation, callbacks, &publisher_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
 
-  if (!callbacks->to_cdr_stream(ros_message, &cdr_stream)) {
-    RMW_SET_ERROR_MSG("failed to convert ros_message to cdr stream");
-    ret = RMW_RET_ERROR;
-    goto fail;
-  }
-  if (cdr_stream.buffer_length == 0) {
-    RMW_SET_ERROR_MSG("no message length set");
-    ret = RMW_RET_ERROR;
-    goto fail;
-  }
-  if (!cdr_stream.buffer) {
-    RMW_SET_ERROR_MSG("no serialized message attached");
-    ret = RMW_RET_ERROR;
-    goto fail;
-  }
-  if (!publish(topic_writer, &cdr_stream)) {
+  std::lock_guard<std::mutex> lock(publisher_info->serialization_mutex_);
+  // An allocation takes the place of the publisher's own buffer, so that it keeps
+  // the capacity reserved for it regardless of what else is published.
+  rcutils_uint8_array_t * serialized_message = publisher_allocation ?
+    &publisher_allocation->serialization_buffer_ : &publisher_info->serialization_buffer_;
+  if (!publisher_info->publish(ros_message, serialized_message)) {
     RMW_SET_ERROR_MSG("failed to publish message");
-    ret = RMW_RET_ERROR;
-    goto fail;
+    return RMW_RET_ERROR;
   }
-
-fail:
-  cdr_stream.allocator.deallocate(cdr_stream.buffer, cdr_stream.allocator.state);
-  return ret;
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -143,7 +113,6 @@ rmw_publish_serialized_message(
   const rmw_serialized_message_t * serialized_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void) allocation;
   RMW_CHECK_FOR_NULL_WITH_MSG(
     publisher, "publisher handle is null",
     return RMW_RET_INVALID_ARGUMENT);
@@ -165,13 +134,22 @@ rmw_publish_serialized_message(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return RMW_RET_ERROR;
   }
-  DDS::DataWriter * topic_writer = publisher_info->topic_writer_;
-  if (!topic_writer) {
-    RMW_SET_ERROR_MSG("topic writer handle is null");
+  if (!publisher_info->data_writer_) {
+    RMW_SET_ERROR_MSG("data writer handle is null");
     return RMW_RET_ERROR;
   }
 
-  bool published = publish(topic_writer, serialized_message);
+  ConnextStaticPublisherAllocation * publisher_allocation = nullptr;
+  rmw_ret_t ret = get_publisher_allocation(allocation, callbacks, &publisher_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
+  // The allocation is only validated: the message is written straight from the
+  // caller's buffer, so there is nothing to serialize into it.
+
+  std::lock_guard<std::mutex> lock(publisher_info->serialization_mutex_);
+  bool published = publisher_info->write(serialized_message);
   if (!published) {
     RMW_SET_ERROR_MSG("failed to publish message");
     return RMW_RET_ERROR;
@@ -185,11 +163,34 @@ rmw_publish_loaned_message(
   void * ros_message,
   rmw_publisher_allocation_t * allocation)
 {
-  (void) publisher;
-  (void) ros_message;
-  (void) allocation;
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    publisher, "publisher handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher, publisher->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_FOR_NULL_WITH_MSG(
+    ros_message, "ros message handle is null",
+    return RMW_RET_INVALID_ARGUMENT);
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("publisher does not support loaned messages");
+    return RMW_RET_UNSUPPORTED;
+  }
 
-  RMW_SET_ERROR_MSG("rmw_publish_loaned_message not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  ConnextStaticPublisherInfo * publisher_info =
+    static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!publisher_info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!publisher_info->loan_pool_.is_loaned(ros_message)) {
+    RMW_SET_ERROR_MSG("message was not loaned by this publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+
+  // The loan goes back to the publisher whether publishing succeeded or not.
+  rmw_ret_t ret = rmw_publish(publisher, ros_message, allocation);
+  publisher_info->loan_pool_.give_back(ros_message);
+  return ret;
 }
 }  // extern "C"
@@ -22,13 +22,16 @@
 
 #include "rmw/impl/cpp/macros.hpp"
 
+#include "rmw_connext_shared_cpp/compression.hpp"
 #include "rmw_connext_shared_cpp/create_topic.hpp"
+#include "rmw_connext_shared_cpp/node.hpp"
 #include "rmw_connext_shared_cpp/qos.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw_connext_cpp/identifier.hpp"
 
 #include "connext_static_publisher_info.hpp"
+#include "message_type_info.hpp"
 #include "process_topic_and_service_names.hpp"
 #include "type_support_common.hpp"
 
@@ -48,21 +51,64 @@ rmw_init_publisher_allocation(
   const rosidl_runtime_c__Sequence__bound * message_bounds,
   rmw_publisher_allocation_t * allocation)
 {
-  // Unused in current implementation.
-  (void) type_support;
-  (void) message_bounds;
-  (void) allocation;
-  RMW_SET_ERROR_MSG("unimplemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CONNEXT_EXTRACT_MESSAGE_TYPESUPPORT(type_support, ts, RMW_RET_ERROR)
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
+
+  // Unbounded message types are rejected, as their size can't be bounded yet.
+  size_t serialized_size = 0;
+  rmw_ret_t ret = rmw_get_serialized_message_size(type_support, message_bounds, &serialized_size);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
+
+  auto publisher_allocation = static_cast<ConnextStaticPublisherAllocation *>(
+    rmw_allocate(sizeof(ConnextStaticPublisherAllocation)));
+  if (!publisher_allocation) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for publisher allocation");
+    return RMW_RET_BAD_ALLOC;
+  }
+  publisher_allocation->callbacks_ =
+    static_cast<const message_type_support_callbacks_t *>(ts->data);
+  publisher_allocation->serialization_buffer_ = rcutils_get_zero_initialized_uint8_array();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  if (
+    RCUTILS_RET_OK != rcutils_uint8_array_init(
+      &publisher_allocation->serialization_buffer_, serialized_size, &allocator))
+  {
+    RMW_SET_ERROR_MSG("failed to allocate serialization buffer");
+    rmw_free(publisher_allocation);
+    return RMW_RET_BAD_ALLOC;
+  }
+
+  allocation->implementation_identifier = rti_connext_identifier;
+  allocation->data = publisher_allocation;
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
 rmw_fini_publisher_allocation(rmw_publisher_allocation_t * allocation)
 {
-  // Unused in current implementation.
-  (void) allocation;
-  RMW_SET_ERROR_MSG("unimplemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    allocation handle,
+    allocation->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  auto publisher_allocation = static_cast<ConnextStaticPublisherAllocation *>(allocation->data);
+  if (!publisher_allocation) {
+    RMW_SET_ERROR_MSG("publisher allocation is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  rmw_ret_t ret = RMW_RET_OK;
+  if (RCUTILS_RET_OK != rcutils_uint8_array_fini(&publisher_allocation->serialization_buffer_)) {
+    RMW_SET_ERROR_MSG("failed to release serialization buffer");
+    ret = RMW_RET_ERROR;
+  }
+  rmw_free(publisher_allocation);
+  allocation->implementation_identifier = nullptr;
+  allocation->data = nullptr;
+  return ret;
 }
 
 rmw_publisher_t *
@@ -112,11 +158,14 @@ rmw_create_publisher(
   std::string type_name = _create_type_name(callbacks);
   // Past this point, a failure results in unrolling code in the goto fail block.
   DDS::TypeCode * type_code = nullptr;
+  const MessageTypeInfo * type_info = nullptr;
+  EndpointTypeProperties type_properties;
   DDS::DataWriterQos datawriter_qos;
-  DDS::PublisherQos publisher_qos;
   DDS::ReturnCode_t status;
   DDS::Publisher * dds_publisher = nullptr;
   DDS::DataWriter * topic_writer = nullptr;
+  ConnextStaticSerializedDataDataWriter * data_writer = nullptr;
+  ConnextStaticSerializedData * sample = nullptr;
   DDS::Topic * topic = nullptr;
   void * info_buf = nullptr;
   void * listener_buf = nullptr;
@@ -141,6 +190,13 @@ rmw_create_publisher(
     RMW_SET_ERROR_MSG("failed to fetch type code\n");
     goto fail;
   }
+  type_info = get_cached_message_type_info(callbacks);
+  if (!type_info) {
+    // error string was set within the function
+    goto fail;
+  }
+  type_properties.is_bounded = type_info->is_bounded;
+  type_properties.max_serialized_size = type_info->max_serialized_size;
   // This is a non-standard RTI Connext function
   // It allows to register an external type to a static data writer
   // In this case, we register the custom message type to a data writer,
@@ -154,12 +210,6 @@ rmw_create_publisher(
     goto fail;
   }
 
-  status = participant->get_default_publisher_qos(publisher_qos);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to get default publisher qos");
-    goto fail;
-  }
-
   // allocating memory for topic_str
   if (!_process_topic_name(
       topic_name,
@@ -180,10 +230,10 @@ rmw_create_publisher(
   RMW_TRY_PLACEMENT_NEW(publisher_listener, listener_buf, goto fail, ConnextPublisherListener, )
   listener_buf = nullptr;  // Only free the buffer pointer.
 
-  dds_publisher = participant->create_publisher(
-    publisher_qos, publisher_listener, DDS::PUBLICATION_MATCHED_STATUS);
+  // All publishers of the node share a single DDS publisher.
+  dds_publisher = get_node_publisher(node_info);
   if (!dds_publisher) {
-    RMW_SET_ERROR_MSG("failed to create publisher");
+    // error string was set within the function
     goto fail;
   }
 
@@ -193,7 +243,9 @@ rmw_create_publisher(
     goto fail;
   }
 
-  if (!get_datawriter_qos(participant, *qos_profile, topic_str, datawriter_qos)) {
+  if (!get_datawriter_qos(
+      participant, *qos_profile, topic_str, datawriter_qos, &type_properties))
+  {
     // error string was set within the function
     goto fail;
   }
@@ -202,12 +254,27 @@ rmw_create_publisher(
   topic_str = nullptr;
 
   topic_writer = dds_publisher->create_datawriter(
-    topic, datawriter_qos, NULL, DDS::STATUS_MASK_NONE);
+    topic, datawriter_qos, publisher_listener, DDS::PUBLICATION_MATCHED_STATUS);
   if (!topic_writer) {
     RMW_SET_ERROR_MSG("failed to create datawriter");
     goto fail;
   }
 
+  // Narrow the data writer and create the sample used for writing once, so that
+  // publishing does not have to do it for every message.
+  data_writer = ConnextStaticSerializedDataDataWriter::narrow(topic_writer);
+  if (!data_writer) {
+    RMW_SET_ERROR_MSG("failed to narrow data writer");
+    goto fail;
+  }
+  sample = ConnextStaticSerializedDataTypeSupport::create_data();
+  if (!sample) {
+    RMW_SET_ERROR_MSG("failed to create dds message instance");
+    goto fail;
+  }
+  // The sample never owns memory for the serialized data, it only loans the publisher buffer.
+  sample->serialized_data.maximum(0);
+
   // Allocate memory for the ConnextStaticPublisherInfo object.
   info_buf = rmw_allocate(sizeof(ConnextStaticPublisherInfo));
   if (!info_buf) {
@@ -220,7 +287,41 @@ rmw_create_publisher(
   publisher_info->topic_ = topic;
   publisher_info->dds_publisher_ = dds_publisher;
   publisher_info->topic_writer_ = topic_writer;
+  publisher_info->data_writer_ = data_writer;
+  publisher_info->sample_ = sample;
+  sample = nullptr;
   publisher_info->callbacks_ = callbacks;
+  publisher_info->type_info_ = *type_info;
+  publisher_info->is_batching_enabled_ = DDS::BOOLEAN_TRUE == datawriter_qos.batch.enable;
+  publisher_info->is_keep_all_ = DDS::KEEP_ALL_HISTORY_QOS == datawriter_qos.history.kind;
+  // topics are not keyed, so the single instance can also limit the history
+  publisher_info->max_samples_ = datawriter_qos.resource_limits.max_samples;
+  if (
+    DDS::LENGTH_UNLIMITED != datawriter_qos.resource_limits.max_samples_per_instance &&
+    (DDS::LENGTH_UNLIMITED == publisher_info->max_samples_ ||
+    datawriter_qos.resource_limits.max_samples_per_instance < publisher_info->max_samples_))
+  {
+    publisher_info->max_samples_ = datawriter_qos.resource_limits.max_samples_per_instance;
+  }
+  publisher_info->is_send_window_limited_ =
+    DDS::RELIABLE_RELIABILITY_QOS == datawriter_qos.reliability.kind &&
+    DDS::LENGTH_UNLIMITED != datawriter_qos.protocol.rtps_reliable_writer.max_send_window_size;
+  publisher_info->serialization_buffer_ = rcutils_get_zero_initialized_uint8_array();
+  publisher_info->serialization_buffer_.allocator = rcutils_get_default_allocator();
+  publisher_info->is_compression_enabled_ =
+    rmw_connext_shared_cpp::is_compressed_topic(topic_name);
+  publisher_info->compression_buffer_ = rcutils_get_zero_initialized_uint8_array();
+  publisher_info->compression_buffer_.allocator = rcutils_get_default_allocator();
+  if (type_info->is_plain) {
+    // Plain messages don't own any memory, so they can be loaned to the user.
+    if (!publisher_info->loan_pool_.init(
+        type_info->plain_size, ConnextStaticPublisherInfo::max_loaned_messages))
+    {
+      RMW_SET_ERROR_MSG("failed to allocate memory for loaned messages");
+      goto fail;
+    }
+    publisher->can_loan_messages = true;
+  }
   publisher_info->publisher_gid.implementation_identifier = rti_connext_identifier;
   publisher_info->listener_ = publisher_listener;
   publisher_listener = nullptr;
@@ -260,7 +361,7 @@ rmw_create_publisher(
   dds_qos_to_rmw_qos(datawriter_qos, &actual_qos_profile);
   node_info->publisher_listener->add_information(
     node_info->participant->get_instance_handle(),
-    dds_publisher->get_instance_handle(),
+    topic_writer->get_instance_handle(),
     mangled_name,
     type_name,
     actual_qos_profile,
@@ -284,18 +385,11 @@ fail:
   if (publisher) {
     rmw_publisher_free(publisher);
   }
-  if (dds_publisher) {
-    if (topic_writer) {
-      if (dds_publisher->delete_datawriter(topic_writer) != DDS::RETCODE_OK) {
-        std::stringstream ss;
-        ss << "leaking datawriter while handling failure at " <<
-          __FILE__ << ":" << __LINE__ << '\n';
-        (std::cerr << ss.str()).flush();
-      }
-    }
-    if (participant->delete_publisher(dds_publisher) != DDS::RETCODE_OK) {
+  // The shared publisher is kept, it is deleted along with the node.
+  if (topic_writer) {
+    if (dds_publisher->delete_datawriter(topic_writer) != DDS::RETCODE_OK) {
       std::stringstream ss;
-      ss << "leaking publisher while handling failure at " <<
+      ss << "leaking datawriter while handling failure at " <<
         __FILE__ << ":" << __LINE__ << '\n';
       (std::cerr << ss.str()).flush();
     }
@@ -313,7 +407,13 @@ fail:
       publisher_listener->~ConnextPublisherListener(), ConnextPublisherListener)
     rmw_free(publisher_listener);
   }
+  if (sample) {
+    ConnextStaticSerializedDataTypeSupport::delete_data(sample);
+  }
   if (publisher_info) {
+    if (publisher_info->sample_) {
+      ConnextStaticSerializedDataTypeSupport::delete_data(publisher_info->sample_);
+    }
     if (publisher_info->listener_) {
       RMW_TRY_DESTRUCTOR_FROM_WITHIN_FAILURE(
         publisher_info->listener_->~ConnextPublisherListener(), ConnextPublisherListener)
@@ -404,18 +504,69 @@ rmw_publisher_assert_liveliness(const rmw_publisher_t * publisher)
   return RMW_RET_OK;
 }
 
+rmw_ret_t
+rmw_publisher_wait_for_all_acked(const rmw_publisher_t * publisher, rmw_time_t wait_timeout)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (nullptr == info) {
+    RMW_SET_ERROR_MSG("publisher internal data is invalid");
+    return RMW_RET_ERROR;
+  }
+  if (nullptr == info->data_writer_) {
+    RMW_SET_ERROR_MSG("publisher internal datawriter is invalid");
+    return RMW_RET_ERROR;
+  }
+
+  return info->wait_for_acknowledgments(wait_timeout);
+}
+
 rmw_ret_t
 rmw_borrow_loaned_message(
   const rmw_publisher_t * publisher,
   const rosidl_message_type_support_t * type_support,
   void ** ros_message)
 {
-  (void) publisher;
-  (void) type_support;
-  (void) ros_message;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(type_support, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_ARGUMENT_FOR_NULL(ros_message, RMW_RET_INVALID_ARGUMENT);
+  if (nullptr != *ros_message) {
+    RMW_SET_ERROR_MSG("ros message is already initialized");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("publisher does not support loaned messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  RMW_CONNEXT_EXTRACT_MESSAGE_TYPESUPPORT(type_support, ts, RMW_RET_INVALID_ARGUMENT)
+  if (ts->data != info->callbacks_) {
+    RMW_SET_ERROR_MSG("type support does not match the publisher type");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
 
-  RMW_SET_ERROR_MSG("rmw_borrow_loaned_message not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  *ros_message = info->loan_pool_.borrow();
+  if (!*ros_message) {
+    RMW_SET_ERROR_MSG("no loaned message available, too many messages on loan");
+    return RMW_RET_BAD_ALLOC;
+  }
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -423,12 +574,28 @@ rmw_return_loaned_message_from_publisher(
   const rmw_publisher_t * publisher,
   void * loaned_message)
 {
-  (void) publisher;
-  (void) loaned_message;
+  RMW_CHECK_ARGUMENT_FOR_NULL(publisher, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    publisher handle,
+    publisher->implementation_identifier,
+    rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  if (!publisher->can_loan_messages) {
+    RMW_SET_ERROR_MSG("publisher does not support loaned messages");
+    return RMW_RET_UNSUPPORTED;
+  }
 
-  RMW_SET_ERROR_MSG(
-    "rmw_return_loaned_message_from_publisher not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  auto info = static_cast<ConnextStaticPublisherInfo *>(publisher->data);
+  if (!info) {
+    RMW_SET_ERROR_MSG("publisher info handle is null");
+    return RMW_RET_ERROR;
+  }
+  if (!info->loan_pool_.give_back(loaned_message)) {
+    RMW_SET_ERROR_MSG("message was not loaned by this publisher");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -454,7 +621,7 @@ rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
   ConnextStaticPublisherInfo * publisher_info =
     static_cast<ConnextStaticPublisherInfo *>(publisher->data);
   node_info->publisher_listener->remove_information(
-    publisher_info->dds_publisher_->get_instance_handle(), EntityType::Publisher);
+    publisher_info->topic_writer_->get_instance_handle(), EntityType::Publisher);
   node_info->publisher_listener->trigger_graph_guard_condition();
   DDS::Publisher * dds_publisher = publisher_info->dds_publisher_;
 
@@ -462,21 +629,40 @@ rmw_destroy_publisher(rmw_node_t * node, rmw_publisher_t * publisher)
     RMW_SET_ERROR_MSG("failed to delete datawriter");
     ret = RMW_RET_ERROR;
   }
-  if (participant->delete_publisher(dds_publisher) != DDS::RETCODE_OK) {
+  // The publisher is shared by the node and is deleted along with it.
+
+  if (participant->delete_topic(publisher_info->topic_) != DDS::RETCODE_OK) {
     if (RMW_RET_OK == ret) {
-      RMW_SET_ERROR_MSG("failed to delete publisher");
+      RMW_SET_ERROR_MSG("failed to delete topic");
       ret = RMW_RET_ERROR;
     } else {
-      RMW_SAFE_FWRITE_TO_STDERR("failed to delete publisher\n");
+      RMW_SAFE_FWRITE_TO_STDERR("failed to delete topic\n");
     }
   }
 
-  if (participant->delete_topic(publisher_info->topic_) != DDS::RETCODE_OK) {
+  if (
+    ConnextStaticSerializedDataTypeSupport::delete_data(publisher_info->sample_) !=
+    DDS::RETCODE_OK)
+  {
     if (RMW_RET_OK == ret) {
-      RMW_SET_ERROR_MSG("failed to delete topic");
+      RMW_SET_ERROR_MSG("failed to delete dds message instance");
       ret = RMW_RET_ERROR;
     } else {
-      RMW_SAFE_FWRITE_TO_STDERR("failed to delete topic\n");
+      RMW_SAFE_FWRITE_TO_STDERR("failed to delete dds message instance\n");
+    }
+  }
+
+  bool buffers_released =
+    rcutils_uint8_array_fini(&publisher_info->serialization_buffer_) == RCUTILS_RET_OK;
+  buffers_released =
+    rcutils_uint8_array_fini(&publisher_info->compression_buffer_) == RCUTILS_RET_OK &&
+    buffers_released;
+  if (!buffers_released) {
+    if (RMW_RET_OK == ret) {
+      RMW_SET_ERROR_MSG("failed to release serialization buffer");
+      ret = RMW_RET_ERROR;
+    } else {
+      RMW_SAFE_FWRITE_TO_STDERR("failed to release serialization buffer\n");
     }
   }
 
@@ -15,6 +15,7 @@
 #include "rmw/error_handling.h"
 #include "rmw/rmw.h"
 
+#include "./message_type_info.hpp"
 #include "./type_support_common.hpp"
 
 // include patched generated code from the build folder
@@ -71,11 +72,29 @@ rmw_deserialize(
 
 rmw_ret_t
 rmw_get_serialized_message_size(
-  const rosidl_message_type_support_t * /*type_support*/,
-  const rosidl_runtime_c__Sequence__bound * /*message_bounds*/,
-  size_t * /*size*/)
+  const rosidl_message_type_support_t * type_support,
+  const rosidl_runtime_c__Sequence__bound * message_bounds,
+  size_t * size)
 {
-  RMW_SET_ERROR_MSG("unimplemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CONNEXT_EXTRACT_MESSAGE_TYPESUPPORT(type_support, ts, RMW_RET_ERROR)
+  RMW_CHECK_ARGUMENT_FOR_NULL(size, RMW_RET_INVALID_ARGUMENT);
+
+  const message_type_support_callbacks_t * callbacks =
+    static_cast<const message_type_support_callbacks_t *>(ts->data);
+  const MessageTypeInfo * type_info = get_cached_message_type_info(callbacks);
+  if (!type_info) {
+    // error string was set within the function
+    return RMW_RET_ERROR;
+  }
+
+  // Sequence bounds don't carry any length yet, so they can't bound the size of
+  // unbounded strings and sequences.
+  (void) message_bounds;
+  if (!type_info->is_bounded) {
+    RMW_SET_ERROR_MSG("serialized size of unbounded message types is not supported");
+    return RMW_RET_UNSUPPORTED;
+  }
+  *size = type_info->max_serialized_size;
+  return RMW_RET_OK;
 }
 }  // extern "C"
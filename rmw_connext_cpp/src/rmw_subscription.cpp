@@ -20,13 +20,16 @@
 #include "rmw/rmw.h"
 #include "rmw/validate_full_topic_name.h"
 
+#include "rmw_connext_shared_cpp/compression.hpp"
 #include "rmw_connext_shared_cpp/create_topic.hpp"
+#include "rmw_connext_shared_cpp/node.hpp"
 #include "rmw_connext_shared_cpp/qos.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw_connext_cpp/identifier.hpp"
 
 #include "connext_static_subscriber_info.hpp"
+#include "message_type_info.hpp"
 #include "process_topic_and_service_names.hpp"
 #include "type_support_common.hpp"
 
@@ -46,21 +49,67 @@ rmw_init_subscription_allocation(
   const rosidl_runtime_c__Sequence__bound * message_bounds,
   rmw_subscription_allocation_t * allocation)
 {
-  // Unused in current implementation.
-  (void) type_support;
-  (void) message_bounds;
-  (void) allocation;
-  RMW_SET_ERROR_MSG("unimplemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CONNEXT_EXTRACT_MESSAGE_TYPESUPPORT(type_support, ts, RMW_RET_ERROR)
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
+
+  // Unbounded message types are rejected, as their size can't be bounded yet.
+  size_t serialized_size = 0;
+  rmw_ret_t ret = rmw_get_serialized_message_size(type_support, message_bounds, &serialized_size);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
+
+  auto subscription_allocation = static_cast<ConnextStaticSubscriptionAllocation *>(
+    rmw_allocate(sizeof(ConnextStaticSubscriptionAllocation)));
+  if (!subscription_allocation) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for subscription allocation");
+    return RMW_RET_BAD_ALLOC;
+  }
+  subscription_allocation->callbacks_ =
+    static_cast<const message_type_support_callbacks_t *>(ts->data);
+  subscription_allocation->decompression_buffer_ = rcutils_get_zero_initialized_uint8_array();
+  rcutils_allocator_t allocator = rcutils_get_default_allocator();
+  if (
+    RCUTILS_RET_OK != rcutils_uint8_array_init(
+      &subscription_allocation->decompression_buffer_, serialized_size, &allocator))
+  {
+    RMW_SET_ERROR_MSG("failed to allocate decompression buffer");
+    rmw_free(subscription_allocation);
+    return RMW_RET_BAD_ALLOC;
+  }
+
+  allocation->implementation_identifier = rti_connext_identifier;
+  allocation->data = subscription_allocation;
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
 rmw_fini_subscription_allocation(rmw_subscription_allocation_t * allocation)
 {
-  // Unused in current implementation.
-  (void) allocation;
-  RMW_SET_ERROR_MSG("unimplemented");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(allocation, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    allocation handle,
+    allocation->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  auto subscription_allocation =
+    static_cast<ConnextStaticSubscriptionAllocation *>(allocation->data);
+  if (!subscription_allocation) {
+    RMW_SET_ERROR_MSG("subscription allocation is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  rmw_ret_t ret = RMW_RET_OK;
+  if (
+    RCUTILS_RET_OK != rcutils_uint8_array_fini(&subscription_allocation->decompression_buffer_))
+  {
+    RMW_SET_ERROR_MSG("failed to release decompression buffer");
+    ret = RMW_RET_ERROR;
+  }
+  rmw_free(subscription_allocation);
+  allocation->implementation_identifier = nullptr;
+  allocation->data = nullptr;
+  return ret;
 }
 
 rmw_subscription_t *
@@ -112,8 +161,9 @@ rmw_create_subscription(
   std::string type_name = _create_type_name(callbacks);
   // Past this point, a failure results in unrolling code in the goto fail block.
   DDS::TypeCode * type_code = nullptr;
+  const MessageTypeInfo * type_info = nullptr;
+  EndpointTypeProperties type_properties;
   DDS::DataReaderQos datareader_qos;
-  DDS::SubscriberQos subscriber_qos;
   DDS::ReturnCode_t status;
   DDS::Subscriber * dds_subscriber = nullptr;
   DDS::Topic * topic = nullptr;
@@ -141,6 +191,13 @@ rmw_create_subscription(
     RMW_SET_ERROR_MSG("failed to fetch type code\n");
     goto fail;
   }
+  type_info = get_cached_message_type_info(callbacks);
+  if (!type_info) {
+    // error string was set within the function
+    goto fail;
+  }
+  type_properties.is_bounded = type_info->is_bounded;
+  type_properties.max_serialized_size = type_info->max_serialized_size;
   // This is a non-standard RTI Connext function
   // It allows to register an external type to a static data reader
   // In this case, we register the custom message type to a data reader,
@@ -154,12 +211,6 @@ rmw_create_subscription(
     goto fail;
   }
 
-  status = participant->get_default_subscriber_qos(subscriber_qos);
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to get default subscriber qos");
-    goto fail;
-  }
-
   // allocating memory for topic_str
   if (!_process_topic_name(
       topic_name,
@@ -180,10 +231,10 @@ rmw_create_subscription(
   RMW_TRY_PLACEMENT_NEW(subscriber_listener, listener_buf, goto fail, ConnextSubscriberListener, )
   listener_buf = nullptr;  // Only free the buffer pointer.
 
-  dds_subscriber = participant->create_subscriber(
-    subscriber_qos, subscriber_listener, DDS::SUBSCRIPTION_MATCHED_STATUS);
+  // All subscriptions of the node share a single DDS subscriber.
+  dds_subscriber = get_node_subscriber(node_info);
   if (!dds_subscriber) {
-    RMW_SET_ERROR_MSG("failed to create subscriber");
+    // error string was set within the function
     goto fail;
   }
 
@@ -193,7 +244,9 @@ rmw_create_subscription(
     goto fail;
   }
 
-  if (!get_datareader_qos(participant, *qos_profile, topic_str, datareader_qos)) {
+  if (!get_datareader_qos(
+      participant, *qos_profile, topic_str, datareader_qos, &type_properties))
+  {
     // error string was set within the function
     goto fail;
   }
@@ -203,7 +256,7 @@ rmw_create_subscription(
 
   topic_reader = dds_subscriber->create_datareader(
     topic, datareader_qos,
-    NULL, DDS::STATUS_MASK_NONE);
+    subscriber_listener, DDS::SUBSCRIPTION_MATCHED_STATUS);
   if (!topic_reader) {
     RMW_SET_ERROR_MSG("failed to create datareader");
     goto fail;
@@ -232,6 +285,54 @@ rmw_create_subscription(
   subscriber_info->callbacks_ = callbacks;
   subscriber_info->listener_ = subscriber_listener;
   subscriber_listener = nullptr;
+  {
+    // the instance handle of an entity starts with its GUID
+    DDS::InstanceHandle_t reader_instance_handle = topic_reader->get_instance_handle();
+    memcpy(
+      subscriber_info->guid_prefix_, &reader_instance_handle,
+      ConnextStaticSubscriberInfo::guid_prefix_size);
+  }
+  subscriber_info->type_info_ = *type_info;
+  subscriber_info->is_compression_enabled_ =
+    rmw_connext_shared_cpp::is_compressed_topic(topic_name);
+  subscriber_info->sample_loans_ = 0;
+  {
+    // topics are not keyed, so the single instance can also limit the history
+    DDS::Long history_limit = DDS::LENGTH_UNLIMITED;
+    if (DDS::KEEP_LAST_HISTORY_QOS == datareader_qos.history.kind) {
+      history_limit = datareader_qos.history.depth;
+    }
+    const DDS::Long resource_limits[] = {
+      datareader_qos.resource_limits.max_samples,
+      datareader_qos.resource_limits.max_samples_per_instance,
+    };
+    for (DDS::Long limit : resource_limits) {
+      if (
+        DDS::LENGTH_UNLIMITED != limit &&
+        (DDS::LENGTH_UNLIMITED == history_limit || limit < history_limit))
+      {
+        history_limit = limit;
+      }
+    }
+    // keep at least one sample of the history free for new samples
+    size_t max_sample_loans = ConnextStaticSubscriberInfo::max_loaned_messages;
+    if (
+      DDS::LENGTH_UNLIMITED != history_limit &&
+      static_cast<size_t>(history_limit) <= max_sample_loans)
+    {
+      max_sample_loans = history_limit > 0 ? static_cast<size_t>(history_limit) - 1 : 0;
+    }
+    subscriber_info->max_sample_loans_ = max_sample_loans;
+  }
+  if (type_info->is_plain) {
+    // Plain messages don't own any memory, so they can be loaned to the user.
+    if (!subscriber_info->loan_pool_.init(
+        type_info->plain_size, ConnextStaticSubscriberInfo::max_loaned_messages))
+    {
+      RMW_SET_ERROR_MSG("failed to allocate memory for loaned messages");
+      goto fail;
+    }
+  }
 
   subscription->implementation_identifier = rti_connext_identifier;
   subscription->data = subscriber_info;
@@ -259,7 +360,7 @@ rmw_create_subscription(
   dds_qos_to_rmw_qos(datareader_qos, &actual_qos_profile);
   node_info->subscriber_listener->add_information(
     node_info->participant->get_instance_handle(),
-    dds_subscriber->get_instance_handle(),
+    topic_reader->get_instance_handle(),
     mangled_name,
     type_name,
     actual_qos_profile,
@@ -274,7 +375,7 @@ rmw_create_subscription(
   fprintf(stderr, "******\n");
 #endif
 
-  subscription->can_loan_messages = false;
+  subscription->can_loan_messages = type_info->is_plain;
   return subscription;
 fail:
   if (topic_str) {
@@ -285,26 +386,19 @@ fail:
     rmw_subscription_free(subscription);
   }
   // Assumption: participant is valid.
-  if (dds_subscriber) {
-    if (topic_reader) {
-      if (read_condition) {
-        if (topic_reader->delete_readcondition(read_condition) != DDS::RETCODE_OK) {
-          std::stringstream ss;
-          ss << "leaking readcondition while handling failure at " <<
-            __FILE__ << ":" << __LINE__ << '\n';
-          (std::cerr << ss.str()).flush();
-        }
-      }
-      if (dds_subscriber->delete_datareader(topic_reader) != DDS::RETCODE_OK) {
+  // The shared subscriber is kept, it is deleted along with the node.
+  if (topic_reader) {
+    if (read_condition) {
+      if (topic_reader->delete_readcondition(read_condition) != DDS::RETCODE_OK) {
         std::stringstream ss;
-        ss << "leaking datareader while handling failure at " <<
+        ss << "leaking readcondition while handling failure at " <<
           __FILE__ << ":" << __LINE__ << '\n';
         (std::cerr << ss.str()).flush();
       }
     }
-    if (participant->delete_subscriber(dds_subscriber) != DDS::RETCODE_OK) {
+    if (dds_subscriber->delete_datareader(topic_reader) != DDS::RETCODE_OK) {
       std::stringstream ss;
-      std::cerr << "leaking subscriber while handling failure at " <<
+      ss << "leaking datareader while handling failure at " <<
         __FILE__ << ":" << __LINE__ << '\n';
       (std::cerr << ss.str()).flush();
     }
@@ -422,35 +516,37 @@ rmw_destroy_subscription(rmw_node_t * node, rmw_subscription_t * subscription)
   ConnextStaticSubscriberInfo * subscriber_info =
     static_cast<ConnextStaticSubscriberInfo *>(subscription->data);
   node_info->subscriber_listener->remove_information(
-    subscriber_info->dds_subscriber_->get_instance_handle(), EntityType::Subscriber);
+    subscriber_info->topic_reader_->get_instance_handle(), EntityType::Subscriber);
   node_info->subscriber_listener->trigger_graph_guard_condition();
   auto dds_subscriber = subscriber_info->dds_subscriber_;
   auto topic_reader = subscriber_info->topic_reader_;
   auto read_condition = subscriber_info->read_condition_;
 
-  if (topic_reader->delete_readcondition(read_condition) != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("failed to delete readcondition");
+  if (!subscriber_info->end_all_loans()) {
+    RMW_SET_ERROR_MSG("failed to return loaned messages");
     ret = RMW_RET_ERROR;
   }
 
-  if (dds_subscriber->delete_datareader(topic_reader) != DDS::RETCODE_OK) {
+  if (topic_reader->delete_readcondition(read_condition) != DDS::RETCODE_OK) {
     if (RMW_RET_OK == ret) {
-      RMW_SET_ERROR_MSG("failed to delete datareader");
+      RMW_SET_ERROR_MSG("failed to delete readcondition");
       ret = RMW_RET_ERROR;
     } else {
-      RMW_SAFE_FWRITE_TO_STDERR("failed to delete datareader\n");
+      RMW_SAFE_FWRITE_TO_STDERR("failed to delete readcondition\n");
     }
   }
 
-  if (participant->delete_subscriber(dds_subscriber) != DDS::RETCODE_OK) {
+  if (dds_subscriber->delete_datareader(topic_reader) != DDS::RETCODE_OK) {
     if (RMW_RET_OK == ret) {
-      RMW_SET_ERROR_MSG("failed to delete subscriber");
+      RMW_SET_ERROR_MSG("failed to delete datareader");
       ret = RMW_RET_ERROR;
     } else {
-      RMW_SAFE_FWRITE_TO_STDERR("failed to delete subscriber\n");
+      RMW_SAFE_FWRITE_TO_STDERR("failed to delete datareader\n");
     }
   }
 
+  // The subscriber is shared by the node and is deleted along with it.
+
   if (participant->delete_topic(subscriber_info->topic_) != DDS::RETCODE_OK) {
     if (RMW_RET_OK == ret) {
       RMW_SET_ERROR_MSG("failed to delete topic");
@@ -12,53 +12,227 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstdint>
+#include <cstring>
 #include <limits>
+#include <mutex>
 
 #include "rmw/error_handling.h"
 #include "rmw/impl/cpp/macros.hpp"
 #include "rmw/types.h"
 
+#include "rmw_connext_shared_cpp/compression.hpp"
 #include "rmw_connext_shared_cpp/types.hpp"
 
 #include "rmw_connext_cpp/identifier.hpp"
 #include "connext_static_subscriber_info.hpp"
+#include "message_type_info.hpp"
 
 // include patched generated code from the build folder
 #include "./connext_static_serialized_dataSupport.h"
 #include "./connext_static_serialized_data.h"
 
+/// Check if a sample was written by the participant a GUID prefix belongs to.
+/**
+ * \param local_guid_prefix the GUID prefix of the subscription's participant, or `nullptr`
+ *   if local publications are not ignored
+ */
 static bool
 is_local_publication(
   const DDS::SampleInfo & sample_info,
-  DDS::DataReader * dds_data_reader)
+  const DDS::Octet * local_guid_prefix)
 {
-  bool is_local = true;
-  // compare the lower 12 octets of the guids from the sender and this receiver
-  // if they are equal the sample has been sent from this process and should be ignored
-  DDS::GUID_t sender_guid = sample_info.original_publication_virtual_guid;
-  DDS::InstanceHandle_t receiver_instance_handle = dds_data_reader->get_instance_handle();
-  for (size_t i = 0; i < 12; ++i) {
-    DDS::Octet * sender_element = &(sender_guid.value[i]);
-    DDS::Octet * receiver_element =
-      &(reinterpret_cast<DDS::Octet *>(&receiver_instance_handle)[i]);
-    if (*sender_element != *receiver_element) {
-      is_local = false;
-      break;
-    }
+  // if the sender's guid starts with the receiver's prefix, the sample has been sent
+  // from this participant and should be ignored
+  return local_guid_prefix && 0 == memcmp(
+    sample_info.original_publication_virtual_guid.value, local_guid_prefix,
+    ConnextStaticSubscriberInfo::guid_prefix_size);
+}
+
+/// Return the GUID prefix of local publications, if the subscription ignores them.
+static const DDS::Octet *
+get_local_guid_prefix(const rmw_subscription_t * subscription)
+{
+  if (!subscription->options.ignore_local_publications) {
+    return nullptr;
+  }
+  return static_cast<ConnextStaticSubscriberInfo *>(subscription->data)->guid_prefix_;
+}
+
+/// Take a single sample from a data reader, leaving it on loan.
+/**
+ * The caller must return the loan of `dds_messages` and `sample_infos`, whether a message
+ * was taken or not, and even if an error occurs.
+ *
+ * \return `true` if no error occurred, `taken` then tells if the loaned sample holds a message
+ */
+static bool
+take_sample(
+  ConnextStaticSerializedDataDataReader * data_reader,
+  const DDS::Octet * local_guid_prefix,
+  ConnextStaticSerializedDataSeq & dds_messages,
+  DDS::SampleInfoSeq & sample_infos,
+  bool * taken,
+  void * sending_publication_handle)
+{
+  DDS::ReturnCode_t status = data_reader->take(
+    dds_messages,
+    sample_infos,
+    1,
+    DDS::ANY_SAMPLE_STATE,
+    DDS::ANY_VIEW_STATE,
+    DDS::ANY_INSTANCE_STATE);
+  if (status == DDS::RETCODE_NO_DATA) {
+    *taken = false;
+    return true;
+  }
+  if (status != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("take failed");
+    return false;
+  }
+
+  DDS::SampleInfo & sample_info = sample_infos[0];
+  bool ignore_sample = false;
+  if (!sample_info.valid_data) {
+    // skip sample without data
+    ignore_sample = true;
+  } else if (is_local_publication(sample_info, local_guid_prefix)) {
+    ignore_sample = true;
+  }
+  if (sample_info.valid_data && sending_publication_handle) {
+    *static_cast<DDS::InstanceHandle_t *>(sending_publication_handle) =
+      sample_info.publication_handle;
   }
-  return is_local;
+  *taken = !ignore_sample;
+  return true;
+}
+
+/// Get the serialized message held by a loaned sample, without copying it.
+/**
+ * `cdr_stream` points into the loaned sample, or into `decompression_buffer` if the message
+ * is compressed, so it is only valid until the loan is returned or the buffer is reused.
+ * Messages are only checked for compression if `is_compression_enabled`, that is if the topic
+ * is listed in `RMW_CONNEXT_COMPRESSED_TOPICS`.
+ *
+ * \return `true` if successful, or
+ * \return `false` if a compressed message could not be restored
+ */
+static bool
+get_serialized_message(
+  ConnextStaticSerializedData & dds_message,
+  bool is_compression_enabled,
+  rcutils_uint8_array_t * decompression_buffer,
+  rcutils_uint8_array_t * cdr_stream)
+{
+  *cdr_stream = rcutils_get_zero_initialized_uint8_array();
+  cdr_stream->buffer_length = dds_message.serialized_data.length();
+  cdr_stream->buffer_capacity = cdr_stream->buffer_length;
+  cdr_stream->buffer = reinterpret_cast<uint8_t *>(&dds_message.serialized_data[0]);
+
+  size_t decompressed_length = 0;
+  if (
+    !is_compression_enabled ||
+    !rmw_connext_shared_cpp::is_compressed_serialized_message(
+      cdr_stream->buffer, cdr_stream->buffer_length, decompressed_length))
+  {
+    return true;
+  }
+  if (
+    (decompression_buffer->buffer_capacity < decompressed_length &&
+    RCUTILS_RET_OK != rcutils_uint8_array_resize(decompression_buffer, decompressed_length)) ||
+    !rmw_connext_shared_cpp::decompress_serialized_message(
+      cdr_stream->buffer, cdr_stream->buffer_length,
+      decompression_buffer->buffer, decompression_buffer->buffer_capacity))
+  {
+    return false;
+  }
+  cdr_stream->buffer_length = decompressed_length;
+  cdr_stream->buffer_capacity = decompression_buffer->buffer_capacity;
+  cdr_stream->buffer = decompression_buffer->buffer;
+  return true;
+}
+
+/// Get the ROS message held by a loaned sample, if it can be used without converting it.
+/**
+ * This is the case for CDR compatible messages encoded in host byte order, when the sample
+ * holds the whole in-memory representation of the message at a properly aligned address.
+ *
+ * \return the message inside the sample, or
+ * \return `nullptr` if the message must be converted
+ */
+static void *
+get_plain_message(
+  const MessageTypeInfo & type_info,
+  ConnextStaticSerializedData & dds_message,
+  bool is_compression_enabled)
+{
+  if (!type_info.is_cdr_compatible) {
+    return nullptr;
+  }
+  const size_t length = dds_message.serialized_data.length();
+  if (length < encapsulation_header_size + type_info.plain_size) {
+    return nullptr;
+  }
+  uint8_t * data = reinterpret_cast<uint8_t *>(&dds_message.serialized_data[0]);
+  size_t decompressed_length = 0;
+  if (
+    is_compression_enabled &&
+    rmw_connext_shared_cpp::is_compressed_serialized_message(data, length, decompressed_length))
+  {
+    return nullptr;
+  }
+  // encapsulation identifier CDR_BE or CDR_LE, matching the host byte order
+  if (0x00 != data[0] || (is_host_little_endian() ? 0x01 : 0x00) != data[1]) {
+    return nullptr;
+  }
+  uint8_t * message = data + encapsulation_header_size;
+  if (0 != reinterpret_cast<uintptr_t>(message) % type_info.plain_alignment) {
+    return nullptr;
+  }
+  return message;
+}
+
+/// Get the subscription allocation passed to a take, if any.
+/**
+ * \return `RMW_RET_OK` if `allocation` is null or was made for the message type, or
+ * \return `RMW_RET_INCORRECT_RMW_IMPLEMENTATION` if it was made by another implementation, or
+ * \return `RMW_RET_INVALID_ARGUMENT` if it is invalid or made for another message type
+ */
+static rmw_ret_t
+get_subscription_allocation(
+  rmw_subscription_allocation_t * allocation,
+  const message_type_support_callbacks_t * callbacks,
+  ConnextStaticSubscriptionAllocation ** subscription_allocation)
+{
+  *subscription_allocation = nullptr;
+  if (!allocation) {
+    return RMW_RET_OK;
+  }
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    allocation, allocation->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  auto result = static_cast<ConnextStaticSubscriptionAllocation *>(allocation->data);
+  if (!result) {
+    RMW_SET_ERROR_MSG("subscription allocation is null");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (result->callbacks_ != callbacks) {
+    RMW_SET_ERROR_MSG("subscription allocation was made for a different message type");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  *subscription_allocation = result;
+  return RMW_RET_OK;
 }
 
 static bool
 take(
   DDS::DataReader * dds_data_reader,
-  bool ignore_local_publications,
+  const DDS::Octet * local_guid_prefix,
+  bool is_compression_enabled,
   rcutils_uint8_array_t * cdr_stream,
   bool * taken,
-  void * sending_publication_handle,
-  rmw_subscription_allocation_t * allocation)
+  void * sending_publication_handle)
 {
-  (void) allocation;
   if (!dds_data_reader) {
     RMW_SET_ERROR_MSG("dds_data_reader is null");
     return false;
@@ -81,61 +255,57 @@ take(
 
   ConnextStaticSerializedDataSeq dds_messages;
   DDS::SampleInfoSeq sample_infos;
-  bool ignore_sample = false;
-
-  DDS::ReturnCode_t status = data_reader->take(
-    dds_messages,
-    sample_infos,
-    1,
-    DDS::ANY_SAMPLE_STATE,
-    DDS::ANY_VIEW_STATE,
-    DDS::ANY_INSTANCE_STATE);
-  if (status == DDS::RETCODE_NO_DATA) {
-    data_reader->return_loan(dds_messages, sample_infos);
-    *taken = false;
-    return true;
-  }
-  if (status != DDS::RETCODE_OK) {
-    RMW_SET_ERROR_MSG("take failed");
+  if (!take_sample(
+      data_reader, local_guid_prefix, dds_messages, sample_infos, taken,
+      sending_publication_handle))
+  {
     data_reader->return_loan(dds_messages, sample_infos);
     return false;
   }
 
-  DDS::SampleInfo & sample_info = sample_infos[0];
-  if (!sample_info.valid_data) {
-    // skip sample without data
-    ignore_sample = true;
-  } else if (ignore_local_publications && is_local_publication(sample_info, dds_data_reader)) {
-    ignore_sample = true;
-  }
-  if (sample_info.valid_data && sending_publication_handle) {
-    *static_cast<DDS::InstanceHandle_t *>(sending_publication_handle) =
-      sample_info.publication_handle;
-  }
-
-  if (!ignore_sample) {
-    cdr_stream->buffer_length = dds_messages[0].serialized_data.length();
-    cdr_stream->buffer_capacity = cdr_stream->buffer_length;
-    // TODO(karsten1987): This malloc has to go!
-    cdr_stream->buffer =
-      reinterpret_cast<uint8_t *>(malloc(cdr_stream->buffer_length * sizeof(uint8_t)));
-
-    if (cdr_stream->buffer_length > (std::numeric_limits<unsigned int>::max)()) {
+  if (*taken) {
+    const uint8_t * data = reinterpret_cast<const uint8_t *>(
+      &dds_messages[0].serialized_data[0]);
+    const size_t data_length = dds_messages[0].serialized_data.length();
+    size_t decompressed_length = 0;
+    const bool is_compressed = is_compression_enabled &&
+      rmw_connext_shared_cpp::is_compressed_serialized_message(
+      data, data_length, decompressed_length);
+    const size_t message_length = is_compressed ? decompressed_length : data_length;
+    if (message_length > (std::numeric_limits<unsigned int>::max)()) {
       RMW_SET_ERROR_MSG("cdr_stream->buffer_length unexpectedly larger than max unsiged int value");
       data_reader->return_loan(dds_messages, sample_infos);
       *taken = false;
       return false;
     }
-    memcpy(cdr_stream->buffer, &dds_messages[0].serialized_data[0], cdr_stream->buffer_length);
-
-    *taken = true;
-  } else {
-    *taken = false;
+    // reuse the caller's buffer, it is only grown with its own allocator when too small
+    if (
+      cdr_stream->buffer_capacity < message_length &&
+      RCUTILS_RET_OK != rcutils_uint8_array_resize(cdr_stream, message_length))
+    {
+      RMW_SET_ERROR_MSG("failed to resize serialized message");
+      data_reader->return_loan(dds_messages, sample_infos);
+      *taken = false;
+      return false;
+    }
+    if (!is_compressed) {
+      memcpy(cdr_stream->buffer, data, message_length);
+    } else if (
+      !rmw_connext_shared_cpp::decompress_serialized_message(
+        data, data_length, cdr_stream->buffer, cdr_stream->buffer_capacity))
+    {
+      RMW_SET_ERROR_MSG("failed to decompress message");
+      cdr_stream->buffer_length = 0;
+      data_reader->return_loan(dds_messages, sample_infos);
+      *taken = false;
+      return false;
+    }
+    cdr_stream->buffer_length = message_length;
   }
 
   data_reader->return_loan(dds_messages, sample_infos);
 
-  return status == DDS::RETCODE_OK;
+  return true;
 }
 
 extern "C"
@@ -178,27 +348,63 @@ _take(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return RMW_RET_ERROR;
   }
+  ConnextStaticSubscriptionAllocation * subscription_allocation = nullptr;
+  rmw_ret_t ret = get_subscription_allocation(allocation, callbacks, &subscription_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
 
-  // fetch the incoming message as cdr stream
-  rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
-  if (!take(
-      topic_reader, subscription->options.ignore_local_publications, &cdr_stream, taken,
-      sending_publication_handle, allocation))
+  ConnextStaticSerializedDataDataReader * data_reader =
+    ConnextStaticSerializedDataDataReader::narrow(topic_reader);
+  if (!data_reader) {
+    RMW_SET_ERROR_MSG("failed to narrow data reader");
+    return RMW_RET_ERROR;
+  }
+
+  ConnextStaticSerializedDataSeq dds_messages;
+  DDS::SampleInfoSeq sample_infos;
+  if (!take_sample(
+      data_reader, get_local_guid_prefix(subscription), dds_messages,
+      sample_infos, taken, sending_publication_handle))
   {
+    data_reader->return_loan(dds_messages, sample_infos);
     RMW_SET_ERROR_MSG("error occured while taking message");
     return RMW_RET_ERROR;
   }
-  // convert the cdr stream to the message
-  if (*taken && !callbacks->to_message(&cdr_stream, ros_message)) {
-    RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
-    return RMW_RET_ERROR;
+  if (!*taken) {
+    data_reader->return_loan(dds_messages, sample_infos);
+    return RMW_RET_OK;
   }
 
-  // the call to take allocates memory for the serialized message
-  // we have to free this here again
-  free(cdr_stream.buffer);
+  // convert the loaned cdr stream to the message, only compressed messages are copied,
+  // into the allocation if there is one
+  rcutils_uint8_array_t local_decompression_buffer = rcutils_get_zero_initialized_uint8_array();
+  local_decompression_buffer.allocator = rcutils_get_default_allocator();
+  rcutils_uint8_array_t * decompression_buffer = subscription_allocation ?
+    &subscription_allocation->decompression_buffer_ : &local_decompression_buffer;
+  rcutils_uint8_array_t cdr_stream;
+  if (!get_serialized_message(
+      dds_messages[0], subscriber_info->is_compression_enabled_, decompression_buffer,
+      &cdr_stream))
+  {
+    RMW_SET_ERROR_MSG("failed to decompress message");
+    *taken = false;
+    ret = RMW_RET_ERROR;
+  } else if (!callbacks->to_message(&cdr_stream, ros_message)) {
+    RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
+    ret = RMW_RET_ERROR;
+  }
 
-  return RMW_RET_OK;
+  data_reader->return_loan(dds_messages, sample_infos);
+  if (
+    RCUTILS_RET_OK != rcutils_uint8_array_fini(&local_decompression_buffer) &&
+    RMW_RET_OK == ret)
+  {
+    RMW_SET_ERROR_MSG("failed to release decompression buffer");
+    ret = RMW_RET_ERROR;
+  }
+  return ret;
 }
 
 rmw_ret_t
@@ -210,8 +416,6 @@ _take_sequence(
   size_t * taken,
   rmw_subscription_allocation_t * allocation)
 {
-  (void) allocation;
-
   RMW_CHECK_ARGUMENT_FOR_NULL(
     subscription, RMW_RET_INVALID_ARGUMENT);
 
@@ -267,9 +471,14 @@ _take_sequence(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return RMW_RET_ERROR;
   }
+  ConnextStaticSubscriptionAllocation * subscription_allocation = nullptr;
+  rmw_ret_t ret = get_subscription_allocation(allocation, callbacks, &subscription_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
 
-  DDS::DataReader * dds_data_reader = topic_reader;
-  bool ignore_local_publications = subscription->options.ignore_local_publications;
+  const DDS::Octet * local_guid_prefix = get_local_guid_prefix(subscription);
 
   ConnextStaticSerializedDataDataReader * data_reader =
     ConnextStaticSerializedDataDataReader::narrow(topic_reader);
@@ -301,21 +510,32 @@ _take_sequence(
     return RMW_RET_ERROR;
   }
 
+  // compressed messages are restored into this buffer, reused for all samples,
+  // or into the allocation if there is one
+  rcutils_uint8_array_t local_decompression_buffer = rcutils_get_zero_initialized_uint8_array();
+  local_decompression_buffer.allocator = rcutils_get_default_allocator();
+  rcutils_uint8_array_t * decompression_buffer = subscription_allocation ?
+    &subscription_allocation->decompression_buffer_ : &local_decompression_buffer;
+
   for (int ii = 0; ii < dds_messages.length(); ++ii) {
     bool ignore_sample = false;
     const DDS::SampleInfo & sample_info = sample_infos[ii];
     if (!sample_info.valid_data) {
       ignore_sample = true;
-    } else if (ignore_local_publications && is_local_publication(sample_info, dds_data_reader)) {
+    } else if (is_local_publication(sample_info, local_guid_prefix)) {
       ignore_sample = true;
     }
 
     if (!ignore_sample) {
-      rcutils_uint8_array_t cdr_stream = rcutils_get_zero_initialized_uint8_array();
-
-      cdr_stream.buffer_length = dds_messages[ii].serialized_data.length();
-      cdr_stream.buffer_capacity = dds_messages[ii].serialized_data.length();
-      cdr_stream.buffer = reinterpret_cast<uint8_t *>(&dds_messages[ii].serialized_data[0]);
+      rcutils_uint8_array_t cdr_stream;
+      if (
+        !get_serialized_message(
+          dds_messages[ii], subscriber_info->is_compression_enabled_, decompression_buffer,
+          &cdr_stream))
+      {
+        // skip the sample, as when it can't be converted
+        continue;
+      }
 
       if (callbacks->to_message(&cdr_stream, message_sequence->data[*taken])) {
         rmw_gid_t * sender_gid = &message_info_sequence->data[*taken].publisher_gid;
@@ -332,6 +552,10 @@ _take_sequence(
   message_info_sequence->size = *taken;
 
   data_reader->return_loan(dds_messages, sample_infos);
+  if (RCUTILS_RET_OK != rcutils_uint8_array_fini(&local_decompression_buffer)) {
+    RMW_SET_ERROR_MSG("failed to release decompression buffer");
+    return RMW_RET_ERROR;
+  }
   return RMW_RET_OK;
 }
 
@@ -424,11 +648,20 @@ _take_serialized_message(
     RMW_SET_ERROR_MSG("callbacks handle is null");
     return RMW_RET_ERROR;
   }
+  // The allocation is only validated: the message, restored if it is compressed, is
+  // copied straight into the caller's buffer, so no scratch memory is needed.
+  ConnextStaticSubscriptionAllocation * subscription_allocation = nullptr;
+  rmw_ret_t ret = get_subscription_allocation(allocation, callbacks, &subscription_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
 
   // fetch the incoming message as cdr stream
   if (!take(
-      topic_reader, subscription->options.ignore_local_publications, serialized_message, taken,
-      sending_publication_handle, allocation))
+      topic_reader, get_local_guid_prefix(subscription),
+      subscriber_info->is_compression_enabled_, serialized_message, taken,
+      sending_publication_handle))
   {
     RMW_SET_ERROR_MSG("error occured while taking message");
     return RMW_RET_ERROR;
@@ -476,6 +709,140 @@ rmw_take_serialized_message_with_info(
   return RMW_RET_OK;
 }
 
+static rmw_ret_t
+_take_loaned_message(
+  const rmw_subscription_t * subscription,
+  void ** loaned_message,
+  bool * taken,
+  DDS::InstanceHandle_t * sending_publication_handle,
+  rmw_subscription_allocation_t * allocation)
+{
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    subscription, RMW_RET_INVALID_ARGUMENT);
+
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    loaned_message, RMW_RET_INVALID_ARGUMENT);
+
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    taken, RMW_RET_INVALID_ARGUMENT);
+
+  if (!subscription->can_loan_messages) {
+    RMW_SET_ERROR_MSG("subscription does not support loaned messages");
+    return RMW_RET_UNSUPPORTED;
+  }
+
+  ConnextStaticSubscriberInfo * subscriber_info =
+    static_cast<ConnextStaticSubscriberInfo *>(subscription->data);
+  if (!subscriber_info) {
+    RMW_SET_ERROR_MSG("subscriber info handle is null");
+    return RMW_RET_ERROR;
+  }
+  DDS::DataReader * topic_reader = subscriber_info->topic_reader_;
+  if (!topic_reader) {
+    RMW_SET_ERROR_MSG("topic reader handle is null");
+    return RMW_RET_ERROR;
+  }
+  const message_type_support_callbacks_t * callbacks = subscriber_info->callbacks_;
+  if (!callbacks) {
+    RMW_SET_ERROR_MSG("callbacks handle is null");
+    return RMW_RET_ERROR;
+  }
+  ConnextStaticSubscriptionAllocation * subscription_allocation = nullptr;
+  rmw_ret_t ret = get_subscription_allocation(allocation, callbacks, &subscription_allocation);
+  if (RMW_RET_OK != ret) {
+    // error string was set within the function
+    return ret;
+  }
+
+  ConnextStaticSerializedDataDataReader * data_reader =
+    ConnextStaticSerializedDataDataReader::narrow(topic_reader);
+  if (!data_reader) {
+    RMW_SET_ERROR_MSG("failed to narrow data reader");
+    return RMW_RET_ERROR;
+  }
+
+  std::lock_guard<std::mutex> lock(subscriber_info->loan_mutex_);
+  ConnextSubscriptionLoan * loan = subscriber_info->find_loan(nullptr);
+  if (!loan) {
+    RMW_SET_ERROR_MSG("no loaned message available, too many messages on loan");
+    return RMW_RET_ERROR;
+  }
+  if (!take_sample(
+      data_reader, get_local_guid_prefix(subscription), loan->dds_messages_,
+      loan->sample_infos_, taken, sending_publication_handle))
+  {
+    data_reader->return_loan(loan->dds_messages_, loan->sample_infos_);
+    RMW_SET_ERROR_MSG("error occured while taking message");
+    return RMW_RET_ERROR;
+  }
+  if (!*taken) {
+    data_reader->return_loan(loan->dds_messages_, loan->sample_infos_);
+    return RMW_RET_OK;
+  }
+
+  // hand out the message inside the sample as long as the reader history has room
+  void * message = nullptr;
+  if (subscriber_info->sample_loans_ < subscriber_info->max_sample_loans_) {
+    message = get_plain_message(
+      subscriber_info->type_info_, loan->dds_messages_[0],
+      subscriber_info->is_compression_enabled_);
+  }
+  if (message) {
+    ++subscriber_info->sample_loans_;
+    loan->message_ = message;
+    loan->is_sample_loan_ = true;
+    *loaned_message = message;
+    return RMW_RET_OK;
+  }
+
+  // otherwise convert it into memory of the pool and give the sample back right away
+  message = subscriber_info->loan_pool_.borrow();
+  rcutils_uint8_array_t local_decompression_buffer = rcutils_get_zero_initialized_uint8_array();
+  local_decompression_buffer.allocator = rcutils_get_default_allocator();
+  rcutils_uint8_array_t * decompression_buffer = subscription_allocation ?
+    &subscription_allocation->decompression_buffer_ : &local_decompression_buffer;
+  rcutils_uint8_array_t cdr_stream;
+  if (!message) {
+    RMW_SET_ERROR_MSG("failed to allocate memory for loaned message");
+    ret = RMW_RET_BAD_ALLOC;
+  } else if (
+    !get_serialized_message(
+      loan->dds_messages_[0], subscriber_info->is_compression_enabled_, decompression_buffer,
+      &cdr_stream))
+  {
+    RMW_SET_ERROR_MSG("failed to decompress message");
+    ret = RMW_RET_ERROR;
+  } else if (!callbacks->to_message(&cdr_stream, message)) {
+    RMW_SET_ERROR_MSG("can't convert cdr stream to ros message");
+    ret = RMW_RET_ERROR;
+  }
+
+  data_reader->return_loan(loan->dds_messages_, loan->sample_infos_);
+  if (
+    RCUTILS_RET_OK != rcutils_uint8_array_fini(&local_decompression_buffer) &&
+    RMW_RET_OK == ret)
+  {
+    RMW_SET_ERROR_MSG("failed to release decompression buffer");
+    ret = RMW_RET_ERROR;
+  }
+  if (RMW_RET_OK != ret) {
+    if (message) {
+      subscriber_info->loan_pool_.give_back(message);
+    }
+    *taken = false;
+    return ret;
+  }
+  loan->message_ = message;
+  loan->is_sample_loan_ = false;
+  *loaned_message = message;
+  return RMW_RET_OK;
+}
+
 rmw_ret_t
 rmw_take_loaned_message(
   const rmw_subscription_t * subscription,
@@ -483,13 +850,7 @@ rmw_take_loaned_message(
   bool * taken,
   rmw_subscription_allocation_t * allocation)
 {
-  (void) subscription;
-  (void) loaned_message;
-  (void) taken;
-  (void) allocation;
-
-  RMW_SET_ERROR_MSG("rmw_take_loaned_message not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  return _take_loaned_message(subscription, loaned_message, taken, nullptr, allocation);
 }
 
 rmw_ret_t
@@ -500,14 +861,24 @@ rmw_take_loaned_message_with_info(
   rmw_message_info_t * message_info,
   rmw_subscription_allocation_t * allocation)
 {
-  (void) subscription;
-  (void) loaned_message;
-  (void) taken;
-  (void) message_info;
-  (void) allocation;
-
-  RMW_SET_ERROR_MSG("rmw_take_loaned_message_with_info not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  RMW_CHECK_ARGUMENT_FOR_NULL(
+    message_info, RMW_RET_INVALID_ARGUMENT);
+
+  DDS::InstanceHandle_t sending_publication_handle;
+  auto ret = _take_loaned_message(
+    subscription, loaned_message, taken, &sending_publication_handle, allocation);
+  if (ret != RMW_RET_OK) {
+    // Error string is already set.
+    return ret;
+  }
+
+  rmw_gid_t * sender_gid = &message_info->publisher_gid;
+  sender_gid->implementation_identifier = rti_connext_identifier;
+  memset(sender_gid->data, 0, RMW_GID_STORAGE_SIZE);
+  auto detail = reinterpret_cast<ConnextPublisherGID *>(sender_gid->data);
+  detail->publication_handle = sending_publication_handle;
+
+  return RMW_RET_OK;
 }
 
 rmw_ret_t
@@ -515,11 +886,32 @@ rmw_return_loaned_message_from_subscription(
   const rmw_subscription_t * subscription,
   void * loaned_message)
 {
-  (void) subscription;
-  (void) loaned_message;
+  RMW_CHECK_ARGUMENT_FOR_NULL(subscription, RMW_RET_INVALID_ARGUMENT);
+  RMW_CHECK_TYPE_IDENTIFIERS_MATCH(
+    subscription handle,
+    subscription->implementation_identifier, rti_connext_identifier,
+    return RMW_RET_INCORRECT_RMW_IMPLEMENTATION);
+  RMW_CHECK_ARGUMENT_FOR_NULL(loaned_message, RMW_RET_INVALID_ARGUMENT);
+  if (!subscription->can_loan_messages) {
+    RMW_SET_ERROR_MSG("subscription does not support loaned messages");
+    return RMW_RET_UNSUPPORTED;
+  }
 
-  RMW_SET_ERROR_MSG(
-    "rmw_release_loaned_message not implemented for rmw_connext_cpp");
-  return RMW_RET_UNSUPPORTED;
+  auto subscriber_info = static_cast<ConnextStaticSubscriberInfo *>(subscription->data);
+  if (!subscriber_info) {
+    RMW_SET_ERROR_MSG("subscriber info handle is null");
+    return RMW_RET_ERROR;
+  }
+  std::lock_guard<std::mutex> lock(subscriber_info->loan_mutex_);
+  ConnextSubscriptionLoan * loan = subscriber_info->find_loan(loaned_message);
+  if (!loan) {
+    RMW_SET_ERROR_MSG("message was not loaned by this subscription");
+    return RMW_RET_INVALID_ARGUMENT;
+  }
+  if (!subscriber_info->end_loan(loan)) {
+    RMW_SET_ERROR_MSG("failed to return loaned message");
+    return RMW_RET_ERROR;
+  }
+  return RMW_RET_OK;
 }
 }  // extern "C"
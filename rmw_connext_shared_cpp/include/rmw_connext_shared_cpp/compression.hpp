@@ -0,0 +1,95 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RMW_CONNEXT_SHARED_CPP__COMPRESSION_HPP_
+#define RMW_CONNEXT_SHARED_CPP__COMPRESSION_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "rmw_connext_shared_cpp/visibility_control.h"
+
+namespace rmw_connext_shared_cpp
+{
+
+/// Serialized messages smaller than this are never compressed.
+constexpr size_t min_compressed_message_size = 512;
+
+/**
+ * Return `true` if the topic matched `RMW_CONNEXT_COMPRESSED_TOPICS` when init was called.
+ *
+ * Publishers of those topics compress their serialized messages, see
+ * compress_serialized_message(), and only subscriptions of those topics check received
+ * messages with is_compressed_serialized_message().
+ * Compressed messages are not valid CDR, so all the publishers and subscriptions of such a
+ * topic must use this implementation with the same `RMW_CONNEXT_COMPRESSED_TOPICS`.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+is_compressed_topic(const std::string & topic_name);
+
+/// Compress a serialized message.
+/**
+ * The compressed message starts with the encapsulation identifier of the original message,
+ * so that it is written with the same encapsulation, followed by options with a reserved
+ * bit set to mark it as compressed.
+ * Messages are compressed with a byte oriented LZ77 codec, which favors speed over ratio.
+ *
+ * \param[in] message serialized message, encapsulation header included
+ * \param[in] length length of the serialized message
+ * \param[out] compressed buffer the compressed message is written to
+ * \param[in] capacity size of the compressed buffer
+ * \return the length of the compressed message, or
+ * \return 0 if the message is shorter than min_compressed_message_size, doesn't compress to
+ *   fewer bytes than the original, or doesn't fit into `capacity` bytes; the message should
+ *   then be sent as it is
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+size_t
+compress_serialized_message(
+  const uint8_t * message, size_t length, uint8_t * compressed, size_t capacity);
+
+/// Check if a serialized message was compressed by compress_serialized_message().
+/**
+ * \param[in] message serialized message, encapsulation header included
+ * \param[in] length length of the serialized message
+ * \param[out] decompressed_length the length of the original message, if it is compressed
+ * \return `true` if the message is compressed, otherwise `false`
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+is_compressed_serialized_message(
+  const uint8_t * message, size_t length, size_t & decompressed_length);
+
+/// Restore a serialized message compressed by compress_serialized_message().
+/**
+ * Corrupted input is detected and never causes reads or writes out of bounds.
+ *
+ * \param[in] compressed compressed message
+ * \param[in] length length of the compressed message
+ * \param[out] message buffer of at least the length returned by
+ *   is_compressed_serialized_message()
+ * \param[in] capacity size of the message buffer
+ * \return `true` if the message was restored, or
+ * \return `false` if the compressed message is invalid or the buffer is too small
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+decompress_serialized_message(
+  const uint8_t * compressed, size_t length, uint8_t * message, size_t capacity);
+
+}  // namespace rmw_connext_shared_cpp
+
+#endif  // RMW_CONNEXT_SHARED_CPP__COMPRESSION_HPP_
@@ -17,6 +17,8 @@
 
 #include "rmw/types.h"
 
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/types.hpp"
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
 RMW_CONNEXT_SHARED_CPP_PUBLIC
@@ -35,4 +37,31 @@ RMW_CONNEXT_SHARED_CPP_PUBLIC
 const rmw_guard_condition_t *
 node_get_graph_guard_condition(const rmw_node_t * node);
 
+/// Return the DDS publisher shared by all the publishers of a node.
+/**
+ * It is created with the participant's default publisher QoS the first time it is needed,
+ * and deleted along with the participant when the node is destroyed.
+ * Every ROS publisher still creates its own data writer, so GIDs and graph information
+ * stay unique per publisher.
+ *
+ * \param node_info the node's implementation data
+ * \return the shared publisher, or
+ * \return `nullptr` if it could not be created
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+DDS::Publisher *
+get_node_publisher(ConnextNodeInfo * node_info);
+
+/// Return the DDS subscriber shared by all the subscriptions of a node.
+/**
+ * Same as get_node_publisher(), for data readers.
+ *
+ * \param node_info the node's implementation data
+ * \return the shared subscriber, or
+ * \return `nullptr` if it could not be created
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+DDS::Subscriber *
+get_node_subscriber(ConnextNodeInfo * node_info);
+
 #endif  // RMW_CONNEXT_SHARED_CPP__NODE_HPP_
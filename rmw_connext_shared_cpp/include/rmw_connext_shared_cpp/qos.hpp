@@ -16,6 +16,7 @@
 #define RMW_CONNEXT_SHARED_CPP__QOS_HPP_
 
 #include <cassert>
+#include <cstddef>
 #include <limits>
 
 #include "ndds_include.hpp"
@@ -26,26 +27,50 @@
 
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
+/// Properties of the message type of an endpoint, used to tune its QoS.
+struct EndpointTypeProperties
+{
+  /// `true` if every sample of the type has a bounded size.
+  bool is_bounded;
+  /// Largest serialized size of a sample, only meaningful if is_bounded is `true`.
+  size_t max_serialized_size;
+};
+
+/// Get the DataReader QoS for a topic.
+/**
+ * `type_properties` is optional, when it is provided the QoS is tuned for the message type.
+ */
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 bool
 get_datareader_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
   const char * dds_topic_name,
-  DDS::DataReaderQos & datareader_qos);
+  DDS::DataReaderQos & datareader_qos,
+  const EndpointTypeProperties * type_properties = nullptr);
 
+/// Get the DataWriter QoS for a topic.
+/**
+ * `type_properties` is optional, when it is provided the QoS is tuned for the message type.
+ */
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 bool
 get_datawriter_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
   const char * dds_topic_name,
-  DDS::DataWriterQos & datawriter_qos);
+  DDS::DataWriterQos & datawriter_qos,
+  const EndpointTypeProperties * type_properties = nullptr);
 
 RMW_CONNEXT_SHARED_CPP_PUBLIC
 rmw_qos_policy_kind_t
 dds_qos_policy_to_rmw_qos_policy(DDS::QosPolicyId_t policy_id);
 
+/// Convert a ROS duration to a DDS duration, keeping infinite durations infinite.
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+DDS_Duration_t
+rmw_time_to_dds(const rmw_time_t & time);
+
 template<typename AttributeT>
 void
 dds_qos_to_rmw_qos(
@@ -150,6 +150,12 @@ struct ConnextNodeInfo
   CustomSubscriberListener * subscriber_listener;
   rmw_guard_condition_t * graph_guard_condition;
   std::mutex topic_creation_mutex;
+  /// Publisher all data writers of the node are created with, see get_node_publisher().
+  DDS::Publisher * dds_publisher;
+  /// Subscriber all data readers of the node are created with, see get_node_subscriber().
+  DDS::Subscriber * dds_subscriber;
+  /// Guards the lazy creation of dds_publisher and dds_subscriber.
+  std::mutex entity_creation_mutex;
 };
 
 struct ConnextPublisherGID
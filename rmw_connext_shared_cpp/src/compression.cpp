@@ -0,0 +1,308 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rmw_connext_shared_cpp/compression.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+
+// A compressed message is laid out as follows, all integers being little endian:
+//   2 bytes   encapsulation identifier of the original message
+//   1 byte    compressed_options_flag
+//   1 byte    number of padding bytes at the end, as for any serialized message
+//   4 bytes   length of the original message
+//   4 bytes   length of the compressed block
+//   the compressed block, followed by the padding
+//
+// The block is a series of sequences, each made of:
+//   1 byte    token, the high nibble is the literal length, the low nibble the match length
+//             minus min_match_length, 15 meaning that more length bytes follow
+//   literal length bytes, each adding up to 255, the last one being less than 255
+//   the literals
+//   2 bytes   offset of the match, back from the current position
+//   match length bytes, as for the literal length
+// The last sequence only holds literals and ends the block.
+
+constexpr uint8_t compressed_options_flag = 0x80;
+constexpr size_t compressed_header_size = 12;
+constexpr size_t min_match_length = 4;
+constexpr size_t max_match_offset = 65535;
+constexpr size_t hash_bits = 12;
+
+uint32_t
+read_uint32(const uint8_t * data)
+{
+  uint32_t value = 0;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+void
+write_uint32_le(uint8_t * data, uint32_t value)
+{
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+  data[2] = static_cast<uint8_t>(value >> 16);
+  data[3] = static_cast<uint8_t>(value >> 24);
+}
+
+uint32_t
+read_uint32_le(const uint8_t * data)
+{
+  return
+    static_cast<uint32_t>(data[0]) |
+    (static_cast<uint32_t>(data[1]) << 8) |
+    (static_cast<uint32_t>(data[2]) << 16) |
+    (static_cast<uint32_t>(data[3]) << 24);
+}
+
+size_t
+hash(uint32_t sequence)
+{
+  return (sequence * 2654435761u) >> (32 - hash_bits);
+}
+
+/// Append the extra bytes of a length that didn't fit into its token nibble.
+bool
+write_length(size_t length, uint8_t *& out, const uint8_t * out_end)
+{
+  for (; length >= 255; length -= 255) {
+    if (out == out_end) {
+      return false;
+    }
+    *out++ = 255;
+  }
+  if (out == out_end) {
+    return false;
+  }
+  *out++ = static_cast<uint8_t>(length);
+  return true;
+}
+
+/// Read the extra bytes of a length whose token nibble was 15.
+bool
+read_length(size_t & length, const uint8_t *& in, const uint8_t * in_end)
+{
+  uint8_t byte = 255;
+  while (255 == byte) {
+    if (in == in_end || length > (std::numeric_limits<size_t>::max)() - 255) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  }
+  return true;
+}
+
+/// Append a sequence, without a match if match_length is 0.
+bool
+write_sequence(
+  const uint8_t * literals, size_t literal_length, size_t offset, size_t match_length,
+  uint8_t *& out, const uint8_t * out_end)
+{
+  if (out == out_end) {
+    return false;
+  }
+  uint8_t * token = out++;
+  *token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+  if (literal_length >= 15 && !write_length(literal_length - 15, out, out_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(out_end - out) < literal_length) {
+    return false;
+  }
+  memcpy(out, literals, literal_length);
+  out += literal_length;
+  if (0 == match_length) {
+    return true;
+  }
+  if (out_end - out < 2) {
+    return false;
+  }
+  *out++ = static_cast<uint8_t>(offset);
+  *out++ = static_cast<uint8_t>(offset >> 8);
+  const size_t extra_match_length = match_length - min_match_length;
+  *token |= static_cast<uint8_t>(extra_match_length < 15 ? extra_match_length : 15);
+  return extra_match_length < 15 || write_length(extra_match_length - 15, out, out_end);
+}
+
+/// Compress a block, return the compressed length or 0 if it doesn't fit.
+size_t
+compress_block(const uint8_t * in, size_t in_length, uint8_t * out, size_t out_capacity)
+{
+  // positions are stored plus one, so that 0 marks an empty slot
+  uint32_t table[1 << hash_bits] = {};
+  uint8_t * out_position = out;
+  const uint8_t * out_end = out + out_capacity;
+  size_t anchor = 0;
+  size_t position = 0;
+  while (position + min_match_length <= in_length) {
+    const uint32_t sequence = read_uint32(in + position);
+    uint32_t & slot = table[hash(sequence)];
+    const size_t candidate = slot;
+    slot = static_cast<uint32_t>(position + 1);
+    if (
+      0 == candidate || position - (candidate - 1) > max_match_offset ||
+      read_uint32(in + candidate - 1) != sequence)
+    {
+      ++position;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t match_length = min_match_length;
+    while (
+      position + match_length < in_length &&
+      in[match + match_length] == in[position + match_length])
+    {
+      ++match_length;
+    }
+    if (!write_sequence(
+        in + anchor, position - anchor, position - match, match_length, out_position, out_end))
+    {
+      return 0;
+    }
+    position += match_length;
+    anchor = position;
+  }
+  if (!write_sequence(in + anchor, in_length - anchor, 0, 0, out_position, out_end)) {
+    return 0;
+  }
+  return static_cast<size_t>(out_position - out);
+}
+
+/// Decompress a block, which must fill the output exactly.
+bool
+decompress_block(const uint8_t * in, size_t in_length, uint8_t * out, size_t out_length)
+{
+  const uint8_t * in_end = in + in_length;
+  size_t position = 0;
+  while (true) {
+    if (in == in_end) {
+      return false;
+    }
+    const uint8_t token = *in++;
+    size_t literal_length = token >> 4;
+    if (15 == literal_length && !read_length(literal_length, in, in_end)) {
+      return false;
+    }
+    if (
+      static_cast<size_t>(in_end - in) < literal_length ||
+      out_length - position < literal_length)
+    {
+      return false;
+    }
+    memcpy(out + position, in, literal_length);
+    in += literal_length;
+    position += literal_length;
+    if (in == in_end) {
+      break;
+    }
+    if (in_end - in < 2) {
+      return false;
+    }
+    const size_t offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    if (0 == offset || offset > position) {
+      return false;
+    }
+    size_t match_length = token & 0x0f;
+    if (15 == match_length && !read_length(match_length, in, in_end)) {
+      return false;
+    }
+    match_length += min_match_length;
+    if (out_length - position < match_length) {
+      return false;
+    }
+    // the match may overlap the bytes being written, which then repeat
+    const uint8_t * match = out + position - offset;
+    if (offset >= match_length) {
+      memcpy(out + position, match, match_length);
+    } else {
+      for (size_t i = 0; i < match_length; ++i) {
+        out[position + i] = match[i];
+      }
+    }
+    position += match_length;
+  }
+  return position == out_length;
+}
+
+}  // namespace
+
+size_t
+rmw_connext_shared_cpp::compress_serialized_message(
+  const uint8_t * message, size_t length, uint8_t * compressed, size_t capacity)
+{
+  if (
+    length < min_compressed_message_size ||
+    length > (std::numeric_limits<uint32_t>::max)() ||
+    capacity < compressed_header_size)
+  {
+    return 0;
+  }
+  // the compressed message, padding included, must be shorter than the original one
+  size_t max_length = capacity < length ? capacity : length - 1;
+  max_length -= max_length % 4;
+  if (max_length <= compressed_header_size) {
+    return 0;
+  }
+  const size_t block_length = compress_block(
+    message, length, compressed + compressed_header_size, max_length - compressed_header_size);
+  if (0 == block_length) {
+    return 0;
+  }
+  const size_t padding = (4 - block_length % 4) % 4;
+  compressed[0] = message[0];
+  compressed[1] = message[1];
+  compressed[2] = compressed_options_flag;
+  compressed[3] = static_cast<uint8_t>(padding);
+  write_uint32_le(compressed + 4, static_cast<uint32_t>(length));
+  write_uint32_le(compressed + 8, static_cast<uint32_t>(block_length));
+  memset(compressed + compressed_header_size + block_length, 0, padding);
+  return compressed_header_size + block_length + padding;
+}
+
+bool
+rmw_connext_shared_cpp::is_compressed_serialized_message(
+  const uint8_t * message, size_t length, size_t & decompressed_length)
+{
+  if (length < compressed_header_size || compressed_options_flag != message[2]) {
+    return false;
+  }
+  decompressed_length = read_uint32_le(message + 4);
+  return true;
+}
+
+bool
+rmw_connext_shared_cpp::decompress_serialized_message(
+  const uint8_t * compressed, size_t length, uint8_t * message, size_t capacity)
+{
+  size_t decompressed_length = 0;
+  if (
+    !is_compressed_serialized_message(compressed, length, decompressed_length) ||
+    decompressed_length > capacity)
+  {
+    return false;
+  }
+  // the padding may already have been removed by the time the message is received
+  const size_t block_length = read_uint32_le(compressed + 8);
+  if (block_length > length - compressed_header_size) {
+    return false;
+  }
+  return decompress_block(
+    compressed + compressed_header_size, block_length, message, decompressed_length);
+}
@@ -12,8 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <mutex>
+#include <string>
+#include <vector>
 
+#include "rmw_connext_shared_cpp/compression.hpp"
 #include "rmw_connext_shared_cpp/init.hpp"
 
 #include "rcutils/get_env.h"
@@ -29,6 +35,14 @@ static std::once_flag g_run_once_flag;
 static bool g_are_topic_profiles_allowed = false;
 /// Return value of \ref is_publish_mode_overriden().
 static bool g_is_publish_mode_overriden = true;
+/// Topic patterns checked by \ref is_batching_topic().
+static std::vector<std::string> g_batching_topics;
+/// Return value of \ref get_flow_controller_settings().
+static rmw_connext_shared_cpp::FlowControllerSettings g_flow_controller_settings = {0, 0, 0};
+/// Topic patterns checked by \ref is_flow_controlled_topic().
+static std::vector<std::string> g_flow_controlled_topics;
+/// Topic patterns checked by \ref is_compressed_topic().
+static std::vector<std::string> g_compressed_topics;
 
 /// Tri-state retcode used in `set_default_qos_library` and `is_env_variable_set`.
 enum class TristateRetCode {SET, NOT_SET, FAILED};
@@ -70,6 +84,31 @@ set_default_qos_profile(DDS::DomainParticipantFactory * dpf);
 static TristateRetCode
 is_env_variable_set(const char * env_var_name);
 
+/// Read a comma separated list of topic patterns from an environment variable.
+/**
+ * A pattern is either a topic name, or a prefix of topic names followed by `*`.
+ *
+ * \param env_var_name name of the environment variable
+ * \param topic_patterns patterns read from the environment variable
+ * \return false if failed to get the environment variable, else true.
+ */
+static bool
+read_topic_patterns(const char * env_var_name, std::vector<std::string> & topic_patterns);
+
+/// Read a size in bytes from an environment variable.
+/**
+ * \param env_var_name name of the environment variable
+ * \param value the size read, left untouched if the environment variable is not set
+ * \return false if failed to get the environment variable or it is not a size, else true.
+ */
+static bool
+read_size(const char * env_var_name, size_t & value);
+
+/// Return `true` if the topic name matches any of the patterns.
+static bool
+matches_topic_patterns(
+  const std::vector<std::string> & topic_patterns, const std::string & topic_name);
+
 rmw_ret_t
 init()
 {
@@ -125,6 +164,29 @@ init()
           ret = RMW_RET_ERROR;
           return;
       }
+      if (!read_topic_patterns("RMW_CONNEXT_BATCHING_TOPICS", g_batching_topics)) {
+        ret = RMW_RET_ERROR;
+        return;
+      }
+      if (
+        !read_size(
+          "RMW_CONNEXT_FLOW_CONTROLLER_BYTES_PER_SECOND",
+          g_flow_controller_settings.bytes_per_second) ||
+        !read_size(
+          "RMW_CONNEXT_FLOW_CONTROLLER_MAX_BURST_BYTES",
+          g_flow_controller_settings.max_burst_bytes) ||
+        !read_size(
+          "RMW_CONNEXT_FLOW_CONTROLLER_MIN_SAMPLE_SIZE",
+          g_flow_controller_settings.min_sample_size) ||
+        !read_topic_patterns("RMW_CONNEXT_FLOW_CONTROLLER_TOPICS", g_flow_controlled_topics))
+      {
+        ret = RMW_RET_ERROR;
+        return;
+      }
+      if (!read_topic_patterns("RMW_CONNEXT_COMPRESSED_TOPICS", g_compressed_topics)) {
+        ret = RMW_RET_ERROR;
+        return;
+      }
     }
   );
   return ret;
@@ -221,6 +283,70 @@ is_env_variable_set(const char * env_var_name)
   return TristateRetCode::NOT_SET;
 }
 
+static bool
+read_topic_patterns(const char * env_var_name, std::vector<std::string> & topic_patterns)
+{
+  const char * env_var_value = NULL;
+  const char * error = rcutils_get_env(env_var_name, &env_var_value);
+  if (error) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("rcutils_get_env() failed: '%s'", error);
+    return false;
+  }
+  std::string remaining(env_var_value ? env_var_value : "");
+  while (!remaining.empty()) {
+    size_t separator = remaining.find(',');
+    std::string pattern = remaining.substr(0, separator);
+    if (!pattern.empty()) {
+      topic_patterns.push_back(pattern);
+    }
+    if (std::string::npos == separator) {
+      break;
+    }
+    remaining.erase(0, separator + 1);
+  }
+  return true;
+}
+
+static bool
+read_size(const char * env_var_name, size_t & value)
+{
+  const char * env_var_value = NULL;
+  const char * error = rcutils_get_env(env_var_name, &env_var_value);
+  if (error) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING("rcutils_get_env() failed: '%s'", error);
+    return false;
+  }
+  if (!env_var_value || 0 == strcmp("", env_var_value)) {
+    return true;
+  }
+  char * end = NULL;
+  errno = 0;
+  unsigned long long parsed = strtoull(env_var_value, &end, 10);  // NOLINT
+  if (0 != errno || '\0' != *end || '-' == env_var_value[0]) {
+    RMW_SET_ERROR_MSG_WITH_FORMAT_STRING(
+      "invalid value for '%s', expected a size in bytes: '%s'", env_var_name, env_var_value);
+    return false;
+  }
+  value = static_cast<size_t>(parsed);
+  return true;
+}
+
+static bool
+matches_topic_patterns(
+  const std::vector<std::string> & topic_patterns, const std::string & topic_name)
+{
+  for (const auto & pattern : topic_patterns) {
+    if ('*' == pattern.back()) {
+      if (topic_name.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0) {
+        return true;
+      }
+    } else if (topic_name == pattern) {
+      return true;
+    }
+  }
+  return false;
+}
+
 bool
 rmw_connext_shared_cpp::are_topic_profiles_allowed()
 {
@@ -232,3 +358,27 @@ rmw_connext_shared_cpp::is_publish_mode_overriden()
 {
   return g_is_publish_mode_overriden;
 }
+
+bool
+rmw_connext_shared_cpp::is_batching_topic(const std::string & topic_name)
+{
+  return matches_topic_patterns(g_batching_topics, topic_name);
+}
+
+const rmw_connext_shared_cpp::FlowControllerSettings &
+rmw_connext_shared_cpp::get_flow_controller_settings()
+{
+  return g_flow_controller_settings;
+}
+
+bool
+rmw_connext_shared_cpp::is_flow_controlled_topic(const std::string & topic_name)
+{
+  return matches_topic_patterns(g_flow_controlled_topics, topic_name);
+}
+
+bool
+rmw_connext_shared_cpp::is_compressed_topic(const std::string & topic_name)
+{
+  return matches_topic_patterns(g_compressed_topics, topic_name);
+}
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <cstring>
+#include <mutex>
 #include <string>
 
 #include "rcutils/filesystem.h"
@@ -30,6 +31,8 @@
 #include "rmw/validate_namespace.h"
 #include "rmw/validate_node_name.h"
 
+#include "./qos_impl.hpp"
+
 rmw_node_t *
 create_node(
   const char * implementation_identifier,
@@ -162,6 +165,7 @@ create_node(
   void * buf = nullptr;
 
   DDS::DomainParticipant * participant = nullptr;
+  DDS::FlowController * flow_controller = nullptr;
   DDS::DataReader * data_reader = nullptr;
   DDS::PublicationBuiltinTopicDataDataReader * builtin_publication_datareader = nullptr;
   DDS::SubscriptionBuiltinTopicDataDataReader * builtin_subscription_datareader = nullptr;
@@ -323,6 +327,11 @@ create_node(
     goto fail;
   }
 
+  if (!rmw_connext_shared_cpp::create_large_data_flow_controller(participant, flow_controller)) {
+    // error string was set within the function
+    goto fail;
+  }
+
   builtin_subscriber = participant->get_builtin_subscriber();
   if (!builtin_subscriber) {
     RMW_SET_ERROR_MSG("builtin subscriber handle is null");
@@ -410,12 +419,23 @@ create_node(
   node_info->publisher_listener = publisher_listener;
   node_info->subscriber_listener = subscriber_listener;
   node_info->graph_guard_condition = graph_guard_condition;
+  node_info->dds_publisher = nullptr;
+  node_info->dds_subscriber = nullptr;
 
   node_handle->implementation_identifier = implementation_identifier;
   node_handle->data = node_info;
   node_handle->context = context;
   return node_handle;
 fail:
+  if (flow_controller) {
+    status = participant->delete_flowcontroller(flow_controller);
+    if (status != DDS::RETCODE_OK) {
+      std::stringstream ss;
+      ss << "leaking flow controller while handling failure at " <<
+        __FILE__ << ":" << __LINE__;
+      (std::cerr << ss.str()).flush();
+    }
+  }
   status = dpf_->delete_participant(participant);
   if (status != DDS::RETCODE_OK) {
     std::stringstream ss;
@@ -485,6 +505,7 @@ destroy_node(const char * implementation_identifier, rmw_node_t * node)
 
   // This unregisters types which were shared between
   // publishers and subscribers and could not be cleaned up in the delete functions.
+  // It also deletes the publisher and subscriber shared by the node's endpoints.
   if (participant->delete_contained_entities() == DDS::RETCODE_OK) {
     DDS::DomainParticipantFactory * dpf_ = DDS::DomainParticipantFactory::get_instance();
     if (dpf_) {
@@ -545,3 +566,43 @@ node_get_graph_guard_condition(const rmw_node_t * node)
 
   return node_info->graph_guard_condition;
 }
+
+DDS::Publisher *
+get_node_publisher(ConnextNodeInfo * node_info)
+{
+  std::lock_guard<std::mutex> lock(node_info->entity_creation_mutex);
+  if (node_info->dds_publisher) {
+    return node_info->dds_publisher;
+  }
+  DDS::PublisherQos publisher_qos;
+  if (node_info->participant->get_default_publisher_qos(publisher_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get default publisher qos");
+    return nullptr;
+  }
+  node_info->dds_publisher = node_info->participant->create_publisher(
+    publisher_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!node_info->dds_publisher) {
+    RMW_SET_ERROR_MSG("failed to create publisher");
+  }
+  return node_info->dds_publisher;
+}
+
+DDS::Subscriber *
+get_node_subscriber(ConnextNodeInfo * node_info)
+{
+  std::lock_guard<std::mutex> lock(node_info->entity_creation_mutex);
+  if (node_info->dds_subscriber) {
+    return node_info->dds_subscriber;
+  }
+  DDS::SubscriberQos subscriber_qos;
+  if (node_info->participant->get_default_subscriber_qos(subscriber_qos) != DDS::RETCODE_OK) {
+    RMW_SET_ERROR_MSG("failed to get default subscriber qos");
+    return nullptr;
+  }
+  node_info->dds_subscriber = node_info->participant->create_subscriber(
+    subscriber_qos, NULL, DDS::STATUS_MASK_NONE);
+  if (!node_info->dds_subscriber) {
+    RMW_SET_ERROR_MSG("failed to create subscriber");
+  }
+  return node_info->dds_subscriber;
+}
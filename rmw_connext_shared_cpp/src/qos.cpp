@@ -14,22 +14,19 @@
 
 #include "rmw_connext_shared_cpp/qos.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
+#include <string>
 
 #include "rmw/validate_namespace.h"
 #include "rmw/validate_node_name.h"
 
-#include "./qos_impl.hpp"
+#include "rmw_connext_shared_cpp/namespace_prefix.hpp"
 
-namespace
-{
-
-bool
-is_time_unspecified(const rmw_time_t & time)
-{
-  return rmw_time_equal(time, RMW_DURATION_UNSPECIFIED);
-}
+#include "./qos_impl.hpp"
 
 DDS_Duration_t
 rmw_time_to_dds(const rmw_time_t & time)
@@ -43,6 +40,15 @@ rmw_time_to_dds(const rmw_time_t & time)
   return duration;
 }
 
+namespace
+{
+
+bool
+is_time_unspecified(const rmw_time_t & time)
+{
+  return rmw_time_equal(time, RMW_DURATION_UNSPECIFIED);
+}
+
 template<typename DDSEntityQos>
 bool
 set_entity_qos_from_profile_generic(
@@ -160,14 +166,270 @@ set_entity_qos_from_profile(
   return set_entity_qos_from_profile_generic(qos_profile, entity_qos);
 }
 
+/// Largest serialized sample size for which batching is enabled automatically.
+constexpr size_t max_batched_sample_size = 1024;
+/// Upper limit of the serialized data held in a batch, kept below a typical UDP datagram.
+constexpr size_t max_batch_data_bytes = 8192;
+/// Longest time a sample waits in an incomplete batch before being sent.
+constexpr DDS::UnsignedLong batch_max_flush_delay_ns = 1000000;
+/// Metadata sent with each sample of a batch: its flags, length and timestamp.
+constexpr size_t batch_sample_overhead = 16;
+
+bool
+set_datawriter_qos_batching(
+  const char * dds_topic_name,
+  const EndpointTypeProperties & type_properties,
+  DDS::DataWriterQos & datawriter_qos)
+{
+  if (
+    DDS::BOOLEAN_TRUE == datawriter_qos.batch.enable ||
+    !type_properties.is_bounded ||
+    0 == type_properties.max_serialized_size ||
+    type_properties.max_serialized_size > max_batched_sample_size ||
+    !rmw_connext_shared_cpp::is_batching_topic(_strip_ros_prefix_if_exists(dds_topic_name)))
+  {
+    // batching was configured in the QoS profile or doesn't apply to the topic
+    return true;
+  }
+  // max_data_bytes doesn't count the sample metadata, which must still fit into the batch
+  const size_t sample_size = type_properties.max_serialized_size;
+  const size_t samples_per_batch = max_batch_data_bytes / (sample_size + batch_sample_overhead);
+  datawriter_qos.batch.enable = DDS::BOOLEAN_TRUE;
+  datawriter_qos.batch.max_samples = static_cast<DDS::Long>(samples_per_batch);
+  datawriter_qos.batch.max_data_bytes = static_cast<DDS::Long>(samples_per_batch * sample_size);
+  datawriter_qos.batch.max_flush_delay.sec = 0;
+  datawriter_qos.batch.max_flush_delay.nanosec = batch_max_flush_delay_ns;
+  return true;
+}
+
+/// Default of the UDPv4 transport message_size_max property.
+constexpr size_t default_udpv4_message_size_max = 65507;
+/// Room left in a transport message for the RTPS headers and the inline QoS.
+constexpr size_t rtps_message_overhead = 512;
+
+/// Get the largest message the participant's UDPv4 transport sends without fragmenting.
+bool
+get_transport_message_size_max(DDS::DomainParticipant * participant, size_t & message_size_max)
+{
+  message_size_max = default_udpv4_message_size_max;
+  DDS::DomainParticipantQos participant_qos;
+  if (DDS::RETCODE_OK != participant->get_qos(participant_qos)) {
+    RMW_SET_ERROR_MSG("failed to get participant qos");
+    return false;
+  }
+  const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+    participant_qos.property, "dds.transport.UDPv4.builtin.parent.message_size_max");
+  if (property && property->value) {
+    char * end = nullptr;
+    long value = strtol(property->value, &end, 10);  // NOLINT
+    if (end != property->value && value > 0) {
+      message_size_max = static_cast<size_t>(value);
+    }
+  }
+  return true;
+}
+
+/// Choose the publish mode of a data writer from the size of its samples.
+/**
+ * Samples that always fit into a single transport message are written synchronously,
+ * avoiding the hand over to the asynchronous publisher thread.
+ * Samples that may have to be fragmented are written asynchronously, so that writing
+ * them does not block until every fragment was sent.
+ */
+bool
+select_publish_mode(
+  DDS::DomainParticipant * participant,
+  const EndpointTypeProperties * type_properties,
+  DDS::PublishModeQosPolicyKind & publish_mode)
+{
+  publish_mode = DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS;
+  if (!type_properties || !type_properties->is_bounded) {
+    return true;
+  }
+  size_t message_size_max = 0;
+  if (!get_transport_message_size_max(participant, message_size_max)) {
+    return false;
+  }
+  if (type_properties->max_serialized_size + rtps_message_overhead <= message_size_max) {
+    publish_mode = DDS::SYNCHRONOUS_PUBLISH_MODE_QOS;
+  }
+  return true;
+}
+
+/// Size of the tokens of the large data flow controller.
+constexpr size_t flow_controller_bytes_per_token = 1024;
+/// Period at which tokens are added to the large data flow controller, for fast rates.
+constexpr size_t flow_controller_period_ns = 10000000;
+/// Burst size of the large data flow controller when none was configured.
+constexpr size_t default_flow_controller_max_burst_bytes = 65536;
+
+bool
+is_large_data_writer(
+  const char * dds_topic_name,
+  const EndpointTypeProperties * type_properties)
+{
+  const auto & settings = rmw_connext_shared_cpp::get_flow_controller_settings();
+  if (0 == settings.bytes_per_second) {
+    return false;
+  }
+  if (rmw_connext_shared_cpp::is_flow_controlled_topic(
+      _strip_ros_prefix_if_exists(dds_topic_name)))
+  {
+    return true;
+  }
+  return
+    0 != settings.min_sample_size && type_properties &&
+    (!type_properties->is_bounded ||
+    type_properties->max_serialized_size >= settings.min_sample_size);
+}
+
+bool
+set_datawriter_qos_flow_controller(
+  const char * dds_topic_name,
+  const EndpointTypeProperties * type_properties,
+  DDS::DataWriterQos & datawriter_qos)
+{
+  const char * flow_controller_name = datawriter_qos.publish_mode.flow_controller_name;
+  if (
+    !is_large_data_writer(dds_topic_name, type_properties) ||
+    (flow_controller_name && 0 != strcmp(DDS_DEFAULT_FLOW_CONTROLLER_NAME, flow_controller_name)))
+  {
+    // no flow control wanted, or a flow controller was chosen in the QoS profile
+    return true;
+  }
+  // flow controllers only apply to asynchronous writers
+  datawriter_qos.publish_mode.kind = DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS;
+  DDS::String_free(datawriter_qos.publish_mode.flow_controller_name);
+  datawriter_qos.publish_mode.flow_controller_name =
+    DDS::String_dup(rmw_connext_shared_cpp::large_data_flow_controller_name);
+  if (!datawriter_qos.publish_mode.flow_controller_name) {
+    RMW_SET_ERROR_MSG("failed to allocate flow controller name");
+    return false;
+  }
+  return true;
+}
+
+/// Size of the pool buffers when samples have no bound or are too large to preallocate.
+constexpr size_t default_pool_buffer_max_size = 4096;
+/// Upper limit of the sample memory preallocated for the history of one endpoint.
+constexpr size_t max_preallocated_history_bytes = 8 * 1024 * 1024;
+
+/// Choose the largest sample size served from the preallocated history pool.
+/**
+ * Bounded samples are preallocated at their maximum serialized size for the whole
+ * history, as long as that stays within max_preallocated_history_bytes, so that
+ * writing and reading them never allocates and small types don't reserve more than
+ * they need.
+ * Other samples keep the default size, larger ones being allocated on demand.
+ */
+template<typename DDSEntityQos>
+size_t
+get_pool_buffer_max_size(
+  const EndpointTypeProperties * type_properties,
+  const DDSEntityQos & entity_qos)
+{
+  if (
+    !type_properties || !type_properties->is_bounded ||
+    0 == type_properties->max_serialized_size)
+  {
+    return default_pool_buffer_max_size;
+  }
+  DDS::Long history_size = entity_qos.history.depth;
+  if (DDS::KEEP_ALL_HISTORY_QOS == entity_qos.history.kind) {
+    history_size = entity_qos.resource_limits.max_samples;
+  }
+  if (
+    history_size <= 0 ||
+    type_properties->max_serialized_size >
+    max_preallocated_history_bytes / static_cast<size_t>(history_size))
+  {
+    // unlimited history, or too much memory to reserve up front
+    return default_pool_buffer_max_size;
+  }
+  return type_properties->max_serialized_size;
+}
+
+/// Add the fast pool buffer size property, unless the QoS profile file specified it.
+template<typename DDSEntityQos>
+bool
+add_pool_buffer_max_size_property(
+  const char * property_name,
+  const EndpointTypeProperties * type_properties,
+  DDSEntityQos & entity_qos)
+{
+  const std::string pool_buffer_max_size =
+    std::to_string(get_pool_buffer_max_size(type_properties, entity_qos));
+  DDS::ReturnCode_t status = DDS::PropertyQosPolicyHelper::add_property(
+    entity_qos.property,
+    property_name,
+    pool_buffer_max_size.c_str(),
+    DDS::BOOLEAN_FALSE);
+  if (DDS::RETCODE_OK != status && DDS::RETCODE_PRECONDITION_NOT_MET != status) {
+    RMW_SET_ERROR_MSG("failed to add qos property");
+    return false;
+  }
+  return true;
+}
+
 }  // anonymous namespace
 
+bool
+rmw_connext_shared_cpp::create_large_data_flow_controller(
+  DDS::DomainParticipant * participant, DDS::FlowController *& flow_controller)
+{
+  flow_controller = nullptr;
+  const auto & settings = get_flow_controller_settings();
+  if (0 == settings.bytes_per_second) {
+    return true;
+  }
+
+  DDS::FlowControllerProperty_t property;
+  if (DDS::RETCODE_OK != participant->get_default_flowcontroller_property(property)) {
+    RMW_SET_ERROR_MSG("failed to get default flow controller property");
+    return false;
+  }
+  // Add tokens every 10 milliseconds, or one token at a time when the rate is so low
+  // that less than a token would be added per period.
+  const size_t bytes_per_period =
+    settings.bytes_per_second * flow_controller_period_ns / 1000000000;
+  size_t period_ns = flow_controller_period_ns;
+  size_t tokens_per_period = bytes_per_period / flow_controller_bytes_per_token;
+  if (0 == tokens_per_period) {
+    tokens_per_period = 1;
+    period_ns = 1000000000 * flow_controller_bytes_per_token / settings.bytes_per_second;
+  }
+  size_t max_burst_bytes = settings.max_burst_bytes;
+  if (0 == max_burst_bytes) {
+    max_burst_bytes = default_flow_controller_max_burst_bytes;
+  }
+  size_t max_tokens = max_burst_bytes / flow_controller_bytes_per_token;
+  if (max_tokens < tokens_per_period) {
+    max_tokens = tokens_per_period;
+  }
+  const size_t max_long = static_cast<size_t>(std::numeric_limits<DDS::Long>::max());
+  property.token_bucket.max_tokens = static_cast<DDS::Long>(std::min(max_tokens, max_long));
+  property.token_bucket.tokens_added_per_period =
+    static_cast<DDS::Long>(std::min(tokens_per_period, max_long));
+  property.token_bucket.bytes_per_token = static_cast<DDS::Long>(flow_controller_bytes_per_token);
+  property.token_bucket.period.sec = static_cast<DDS::Long>(period_ns / 1000000000);
+  property.token_bucket.period.nanosec = static_cast<DDS::UnsignedLong>(period_ns % 1000000000);
+
+  flow_controller = participant->create_flowcontroller(
+    large_data_flow_controller_name, property);
+  if (!flow_controller) {
+    RMW_SET_ERROR_MSG("failed to create large data flow controller");
+    return false;
+  }
+  return true;
+}
+
 bool
 get_datareader_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
   const char * dds_topic_name,
-  DDS::DataReaderQos & datareader_qos)
+  DDS::DataReaderQos & datareader_qos,
+  const EndpointTypeProperties * type_properties)
 {
   bool topic_profile_found = false;
 
@@ -207,17 +469,6 @@ get_datareader_qos(
 
   // This property will be added only if it wasn't specified in the external QoS profile file.
   DDS::ReturnCode_t status = DDS::PropertyQosPolicyHelper::add_property(
-    datareader_qos.property,
-    "dds.data_reader.history.memory_manager.fast_pool.pool_buffer_max_size",
-    "4096",
-    DDS::BOOLEAN_FALSE);
-  if (DDS::RETCODE_OK != status && DDS::RETCODE_PRECONDITION_NOT_MET != status) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
-    return false;
-  }
-
-  // This property will be added only if it wasn't specified in the external QoS profile file.
-  status = DDS::PropertyQosPolicyHelper::add_property(
     datareader_qos.property,
     "reader_resource_limits.dynamically_allocate_fragmented_samples",
     "1",
@@ -227,16 +478,16 @@ get_datareader_qos(
     return false;
   }
 
-  if (topic_profile_found) {
-    // ignore ROS QoS when a topic profile was found.
-    return true;
-  }
-
-  if (!set_entity_qos_from_profile(qos_profile, datareader_qos)) {
+  // ignore ROS QoS when a topic profile was found.
+  if (!topic_profile_found && !set_entity_qos_from_profile(qos_profile, datareader_qos)) {
     return false;
   }
 
-  return true;
+  // The pool buffer size depends on the history, so it is chosen once the QoS is complete.
+  // This property will be added only if it wasn't specified in the external QoS profile file.
+  return add_pool_buffer_max_size_property(
+    "dds.data_reader.history.memory_manager.fast_pool.pool_buffer_max_size",
+    type_properties, datareader_qos);
 }
 
 bool
@@ -244,7 +495,8 @@ get_datawriter_qos(
   DDS::DomainParticipant * participant,
   const rmw_qos_profile_t & qos_profile,
   const char * dds_topic_name,
-  DDS::DataWriterQos & datawriter_qos)
+  DDS::DataWriterQos & datawriter_qos,
+  const EndpointTypeProperties * type_properties)
 {
   bool topic_profile_found = false;
   if (rmw_connext_shared_cpp::are_topic_profiles_allowed()) {
@@ -274,33 +526,37 @@ get_datawriter_qos(
     }
   }
 
-  // This property will be added only if it wasn't specified in the external QoS profile file.
-  DDS::ReturnCode_t status = DDS::PropertyQosPolicyHelper::add_property(
-    datawriter_qos.property,
-    "dds.data_writer.history.memory_manager.fast_pool.pool_buffer_max_size",
-    "4096",
-    DDS::BOOLEAN_FALSE);
-  if (DDS::RETCODE_OK != status && DDS::RETCODE_PRECONDITION_NOT_MET != status) {
-    RMW_SET_ERROR_MSG("failed to add qos property");
+  if (
+    rmw_connext_shared_cpp::is_publish_mode_overriden() &&
+    !select_publish_mode(participant, type_properties, datawriter_qos.publish_mode.kind))
+  {
     return false;
   }
 
-  if (rmw_connext_shared_cpp::is_publish_mode_overriden()) {
-    // TODO(wjwwood): conditionally use the async publish mode using a heuristic:
-    //  https://github.com/ros2/rmw_connext/issues/190
-    datawriter_qos.publish_mode.kind = DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS;
+  if (
+    type_properties &&
+    !set_datawriter_qos_batching(dds_topic_name, *type_properties, datawriter_qos))
+  {
+    return false;
   }
 
-  if (topic_profile_found) {
-    // ignore ROS QoS when a topic profile was found.
-    return true;
+  if (
+    rmw_connext_shared_cpp::is_publish_mode_overriden() &&
+    !set_datawriter_qos_flow_controller(dds_topic_name, type_properties, datawriter_qos))
+  {
+    return false;
   }
 
-  if (!set_entity_qos_from_profile(qos_profile, datawriter_qos)) {
+  // ignore ROS QoS when a topic profile was found.
+  if (!topic_profile_found && !set_entity_qos_from_profile(qos_profile, datawriter_qos)) {
     return false;
   }
 
-  return true;
+  // The pool buffer size depends on the history, so it is chosen once the QoS is complete.
+  // This property will be added only if it wasn't specified in the external QoS profile file.
+  return add_pool_buffer_max_size_property(
+    "dds.data_writer.history.memory_manager.fast_pool.pool_buffer_max_size",
+    type_properties, datawriter_qos);
 }
 
 rmw_qos_policy_kind_t
@@ -15,6 +15,11 @@
 #ifndef QOS_IMPL_HPP_
 #define QOS_IMPL_HPP_
 
+#include <cstddef>
+#include <string>
+
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+#include "rmw_connext_shared_cpp/qos.hpp"
 #include "rmw_connext_shared_cpp/visibility_control.h"
 
 namespace rmw_connext_shared_cpp
@@ -40,6 +45,56 @@ RMW_CONNEXT_SHARED_CPP_PUBLIC
 bool
 is_publish_mode_overriden();
 
+/**
+ * Return `true` if the topic matched `RMW_CONNEXT_BATCHING_TOPICS` when init was called.
+ *
+ * Data writers of those topics with a small bounded message type batch their samples.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+is_batching_topic(const std::string & topic_name);
+
+/// Settings of the flow controller shared by the large data writers of a participant.
+struct FlowControllerSettings
+{
+  /// Sustained rate of the flow controller, 0 if it is disabled.
+  size_t bytes_per_second;
+  /// Amount of data that may be sent at once after being idle, 0 to use the default.
+  size_t max_burst_bytes;
+  /// Writers of unbounded types or with samples this large use the flow controller,
+  /// 0 to only select writers by topic.
+  size_t min_sample_size;
+};
+
+/// Name of the flow controller created on every participant for large data writers.
+constexpr char large_data_flow_controller_name[] = "ros2.large_data";
+
+/**
+ * Return the flow controller settings read from the `RMW_CONNEXT_FLOW_CONTROLLER_*`
+ * environment variables when init was called.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+const FlowControllerSettings &
+get_flow_controller_settings();
+
+/**
+ * Return `true` if the topic matched `RMW_CONNEXT_FLOW_CONTROLLER_TOPICS` when init was called.
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+is_flow_controlled_topic(const std::string & topic_name);
+
+/// Create the flow controller for large data writers on a participant.
+/**
+ * \param participant the participant to create the flow controller on
+ * \param flow_controller the created flow controller, `nullptr` if it is disabled
+ * \return `true` if successful (including when disabled), otherwise `false` and the error is set
+ */
+RMW_CONNEXT_SHARED_CPP_PUBLIC
+bool
+create_large_data_flow_controller(
+  DDS::DomainParticipant * participant, DDS::FlowController *& flow_controller);
+
 }  // namespace rmw_connext_shared_cpp
 
 #endif  // QOS_IMPL_HPP_
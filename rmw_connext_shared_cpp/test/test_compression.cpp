@@ -0,0 +1,145 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rmw_connext_shared_cpp/compression.hpp"
+
+using rmw_connext_shared_cpp::compress_serialized_message;
+using rmw_connext_shared_cpp::decompress_serialized_message;
+using rmw_connext_shared_cpp::is_compressed_serialized_message;
+
+namespace
+{
+
+/// Build a serialized message with a CDR_LE encapsulation header and a text-like payload.
+std::vector<uint8_t>
+make_text_message(size_t length)
+{
+  const char text[] = "level: 0, name: /diagnostics/cpu, message: OK, values: [] ";
+  std::vector<uint8_t> message(length);
+  message[0] = 0x00;
+  message[1] = 0x01;
+  for (size_t i = 4; i < length; ++i) {
+    message[i] = static_cast<uint8_t>(text[i % (sizeof(text) - 1)]);
+  }
+  return message;
+}
+
+/// Build a serialized message whose payload doesn't compress.
+std::vector<uint8_t>
+make_random_message(size_t length)
+{
+  std::vector<uint8_t> message(length);
+  message[1] = 0x01;
+  uint32_t state = 42;
+  for (size_t i = 4; i < length; ++i) {
+    state = state * 1664525u + 1013904223u;
+    message[i] = static_cast<uint8_t>(state >> 24);
+  }
+  return message;
+}
+
+}  // namespace
+
+TEST(TestCompression, round_trip) {
+  for (size_t length : {512u, 1000u, 4096u, 100003u}) {
+    const std::vector<uint8_t> message = make_text_message(length);
+    std::vector<uint8_t> compressed(length);
+    const size_t compressed_length = compress_serialized_message(
+      message.data(), message.size(), compressed.data(), compressed.size());
+    ASSERT_NE(0u, compressed_length) << "expected text of " << length << " bytes to compress";
+    EXPECT_LT(compressed_length, length / 4);
+    EXPECT_EQ(0u, compressed_length % 4) << "expected padding to 4 bytes";
+    EXPECT_EQ(message[0], compressed[0]) << "expected the original encapsulation identifier";
+    EXPECT_EQ(message[1], compressed[1]) << "expected the original encapsulation identifier";
+
+    size_t decompressed_length = 0;
+    ASSERT_TRUE(
+      is_compressed_serialized_message(
+        compressed.data(), compressed_length, decompressed_length));
+    ASSERT_EQ(length, decompressed_length);
+    std::vector<uint8_t> decompressed(decompressed_length);
+    ASSERT_TRUE(
+      decompress_serialized_message(
+        compressed.data(), compressed_length, decompressed.data(), decompressed.size()));
+    EXPECT_EQ(message, decompressed);
+
+    // the receiving side may strip the padding
+    const size_t padding = compressed[3] & 0x03;
+    ASSERT_TRUE(
+      decompress_serialized_message(
+        compressed.data(), compressed_length - padding, decompressed.data(), decompressed.size()));
+    EXPECT_EQ(message, decompressed);
+  }
+}
+
+TEST(TestCompression, not_worth_compressing) {
+  std::vector<uint8_t> buffer(8192);
+
+  const std::vector<uint8_t> short_message = make_text_message(100);
+  EXPECT_EQ(
+    0u, compress_serialized_message(
+      short_message.data(), short_message.size(), buffer.data(), buffer.size()));
+
+  const std::vector<uint8_t> random_message = make_random_message(4096);
+  EXPECT_EQ(
+    0u, compress_serialized_message(
+      random_message.data(), random_message.size(), buffer.data(), buffer.size()));
+
+  const std::vector<uint8_t> text_message = make_text_message(4096);
+  EXPECT_EQ(
+    0u, compress_serialized_message(
+      text_message.data(), text_message.size(), buffer.data(), 16)) <<
+    "expected no compression into a buffer that is too small";
+
+  size_t decompressed_length = 0;
+  EXPECT_FALSE(
+    is_compressed_serialized_message(
+      text_message.data(), text_message.size(), decompressed_length)) <<
+    "expected a plain serialized message not to be detected as compressed";
+}
+
+TEST(TestCompression, corrupted_input) {
+  const std::vector<uint8_t> message = make_text_message(4096);
+  std::vector<uint8_t> compressed(message.size());
+  const size_t compressed_length = compress_serialized_message(
+    message.data(), message.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0u, compressed_length);
+  compressed.resize(compressed_length);
+
+  std::vector<uint8_t> decompressed(message.size());
+  EXPECT_FALSE(
+    decompress_serialized_message(
+      compressed.data(), compressed.size(), decompressed.data(), decompressed.size() - 1)) <<
+    "expected failure with a buffer that is too small";
+  EXPECT_FALSE(
+    decompress_serialized_message(
+      compressed.data(), compressed.size() / 2, decompressed.data(), decompressed.size())) <<
+    "expected failure with a truncated message";
+
+  // flipping any bit of the block must never read or write out of bounds
+  for (size_t i = 12; i < compressed.size(); ++i) {
+    for (uint8_t bit = 1; bit != 0; bit = static_cast<uint8_t>(bit << 1)) {
+      std::vector<uint8_t> corrupted = compressed;
+      corrupted[i] ^= bit;
+      decompress_serialized_message(
+        corrupted.data(), corrupted.size(), decompressed.data(), decompressed.size());
+    }
+  }
+}
@@ -20,5 +20,14 @@ constexpr char allow_topic_qos_vn[] = "RMW_CONNEXT_ALLOW_TOPIC_QOS_PROFILES";
 constexpr char do_not_override_pub_mode_vn[] = "RMW_CONNEXT_DO_NOT_OVERRIDE_PUBLICATION_MODE";
 constexpr char profile_library_vn[] = "RMW_CONNEXT_QOS_PROFILE_LIBRARY";
 constexpr char default_qos_profile_vn[] = "RMW_CONNEXT_DEFAULT_QOS_PROFILE";
+constexpr char batching_topics_vn[] = "RMW_CONNEXT_BATCHING_TOPICS";
+constexpr char flow_controller_bytes_per_second_vn[] =
+  "RMW_CONNEXT_FLOW_CONTROLLER_BYTES_PER_SECOND";
+constexpr char flow_controller_max_burst_bytes_vn[] =
+  "RMW_CONNEXT_FLOW_CONTROLLER_MAX_BURST_BYTES";
+constexpr char flow_controller_min_sample_size_vn[] =
+  "RMW_CONNEXT_FLOW_CONTROLLER_MIN_SAMPLE_SIZE";
+constexpr char flow_controller_topics_vn[] = "RMW_CONNEXT_FLOW_CONTROLLER_TOPICS";
+constexpr char compressed_topics_vn[] = "RMW_CONNEXT_COMPRESSED_TOPICS";
 
 #endif  // TEST_QOS_PROFILES__ENVIRONMENT_VARIABLE_NAMES_HPP_
@@ -0,0 +1,263 @@
+// Copyright 2020 Open Source Robotics Foundation, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <string>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "rcutils/get_env.h"
+
+#include "rmw/qos_profiles.h"
+
+#include "rmw_connext_shared_cpp/compression.hpp"
+#include "rmw_connext_shared_cpp/init.hpp"
+#include "rmw_connext_shared_cpp/qos.hpp"
+#include "rmw_connext_shared_cpp/ndds_include.hpp"
+
+// In src folder
+#include "qos_impl.hpp"
+
+#include "./create_participant.hpp"
+#include "./environment_variable_names.hpp"
+#include "../custom_set_env.hpp"
+
+namespace
+{
+
+class QosTypeProperties : public ::testing::Test
+{
+public:
+  void SetUp()
+  {
+    custom_setenv(allow_topic_qos_vn, "");
+    custom_setenv(do_not_override_pub_mode_vn, "");
+    custom_setenv(profile_library_vn, "");
+    custom_setenv(default_qos_profile_vn, "");
+    custom_setenv(batching_topics_vn, "/can/frames,,/imu/*");
+    custom_setenv(flow_controller_bytes_per_second_vn, "10240000");
+    custom_setenv(flow_controller_max_burst_bytes_vn, "");
+    custom_setenv(flow_controller_min_sample_size_vn, "65536");
+    custom_setenv(flow_controller_topics_vn, "/points");
+    custom_setenv(compressed_topics_vn, "/map,/diagnostics*");
+    init();
+  }
+
+  void TearDown()
+  {
+  }
+};
+}  // namespace
+
+TEST_F(QosTypeProperties, test_topic_patterns)
+{
+  EXPECT_TRUE(rmw_connext_shared_cpp::is_batching_topic("/can/frames"));
+  EXPECT_TRUE(rmw_connext_shared_cpp::is_batching_topic("/imu/data"));
+  EXPECT_FALSE(rmw_connext_shared_cpp::is_batching_topic("/can/frames/raw"));
+  EXPECT_FALSE(rmw_connext_shared_cpp::is_batching_topic("/imu"));
+  EXPECT_FALSE(rmw_connext_shared_cpp::is_batching_topic(""));
+
+  EXPECT_TRUE(rmw_connext_shared_cpp::is_compressed_topic("/map"));
+  EXPECT_TRUE(rmw_connext_shared_cpp::is_compressed_topic("/diagnostics_agg"));
+  EXPECT_FALSE(rmw_connext_shared_cpp::is_compressed_topic("/map_updates"));
+}
+
+TEST_F(QosTypeProperties, test_datawriter_qos)
+{
+  auto * participant = create_participant();
+  ASSERT_TRUE(participant);
+
+  EndpointTypeProperties small_bounded_type;
+  small_bounded_type.is_bounded = true;
+  small_bounded_type.max_serialized_size = 64;
+  EndpointTypeProperties unbounded_type;
+  unbounded_type.is_bounded = false;
+  unbounded_type.max_serialized_size = 8;
+
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/imu/data", datawriter_qos,
+        &small_bounded_type)) << "failed to get datawriter qos";
+    EXPECT_EQ(DDS::BOOLEAN_TRUE, datawriter_qos.batch.enable) <<
+      "expected batching for a small bounded type";
+    // 64 bytes of serialized data plus 16 bytes of metadata per sample
+    EXPECT_EQ(8192 / (64 + 16), datawriter_qos.batch.max_samples);
+    EXPECT_EQ(8192 / (64 + 16) * 64, datawriter_qos.batch.max_data_bytes);
+    EXPECT_EQ(0, datawriter_qos.batch.max_flush_delay.sec);
+    EXPECT_EQ(DDS::SYNCHRONOUS_PUBLISH_MODE_QOS, datawriter_qos.publish_mode.kind);
+  }
+
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/imu/data", datawriter_qos,
+        &unbounded_type)) << "failed to get datawriter qos";
+    EXPECT_EQ(DDS::BOOLEAN_FALSE, datawriter_qos.batch.enable) <<
+      "expected no batching for an unbounded type";
+    EXPECT_EQ(DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS, datawriter_qos.publish_mode.kind) <<
+      "expected asynchronous publishing for an unbounded type";
+  }
+
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/local_topic", datawriter_qos,
+        &small_bounded_type)) << "failed to get datawriter qos";
+    EXPECT_EQ(DDS::BOOLEAN_FALSE, datawriter_qos.batch.enable) <<
+      "expected no batching for a topic not matching the patterns";
+  }
+
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/points", datawriter_qos,
+        &small_bounded_type)) << "failed to get datawriter qos";
+    EXPECT_EQ(DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS, datawriter_qos.publish_mode.kind);
+    EXPECT_STREQ(
+      rmw_connext_shared_cpp::large_data_flow_controller_name,
+      datawriter_qos.publish_mode.flow_controller_name) <<
+      "expected the large data flow controller for a topic matching the patterns";
+  }
+
+  {
+    EndpointTypeProperties large_bounded_type;
+    large_bounded_type.is_bounded = true;
+    large_bounded_type.max_serialized_size = 1024 * 1024;
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/image", datawriter_qos,
+        &large_bounded_type)) << "failed to get datawriter qos";
+    EXPECT_EQ(DDS::ASYNCHRONOUS_PUBLISH_MODE_QOS, datawriter_qos.publish_mode.kind) <<
+      "expected asynchronous publishing for samples that need to be fragmented";
+    EXPECT_STREQ(
+      rmw_connext_shared_cpp::large_data_flow_controller_name,
+      datawriter_qos.publish_mode.flow_controller_name) <<
+      "expected the large data flow controller for large samples";
+  }
+}
+
+TEST_F(QosTypeProperties, test_large_data_flow_controller)
+{
+  auto * participant = create_participant();
+  ASSERT_TRUE(participant);
+
+  DDS::FlowController * flow_controller = nullptr;
+  ASSERT_TRUE(
+    rmw_connext_shared_cpp::create_large_data_flow_controller(participant, flow_controller));
+  ASSERT_TRUE(flow_controller);
+  EXPECT_STREQ(
+    rmw_connext_shared_cpp::large_data_flow_controller_name, flow_controller->get_name());
+
+  DDS::FlowControllerProperty_t property;
+  ASSERT_EQ(DDS::RETCODE_OK, flow_controller->get_property(property));
+  // 10240000 bytes per second are 100 tokens of 1024 bytes every 10 milliseconds
+  EXPECT_EQ(1024, property.token_bucket.bytes_per_token);
+  EXPECT_EQ(100, property.token_bucket.tokens_added_per_period);
+  EXPECT_EQ(0, property.token_bucket.period.sec);
+  EXPECT_EQ(10000000u, property.token_bucket.period.nanosec);
+  EXPECT_EQ(100, property.token_bucket.max_tokens);
+
+  EXPECT_EQ(DDS::RETCODE_OK, participant->delete_flowcontroller(flow_controller));
+}
+
+TEST_F(QosTypeProperties, test_pool_buffer_max_size)
+{
+  auto * participant = create_participant();
+  ASSERT_TRUE(participant);
+
+  const char * writer_property_name =
+    "dds.data_writer.history.memory_manager.fast_pool.pool_buffer_max_size";
+  const char * reader_property_name =
+    "dds.data_reader.history.memory_manager.fast_pool.pool_buffer_max_size";
+  EndpointTypeProperties type_properties;
+  type_properties.is_bounded = true;
+
+  // sensor data keeps the last 5 samples
+  type_properties.max_serialized_size = 64;
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/chatter", datawriter_qos,
+        &type_properties)) << "failed to get datawriter qos";
+    const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+      datawriter_qos.property, writer_property_name);
+    ASSERT_TRUE(property);
+    EXPECT_STREQ("64", property->value) << "expected pool buffers sized for a small type";
+  }
+
+  // a 13 byte payload is reported with its 4 byte header and 3 bytes of trailing padding
+  type_properties.max_serialized_size = 4 + 13 + 3;
+  {
+    DDS::DataReaderQos datareader_qos;
+    ASSERT_TRUE(
+      get_datareader_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/chatter", datareader_qos,
+        &type_properties)) << "failed to get datareader qos";
+    const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+      datareader_qos.property, reader_property_name);
+    ASSERT_TRUE(property);
+    EXPECT_STREQ("20", property->value) <<
+      "expected pool buffers sized for the reported size of an odd sized type";
+  }
+
+  type_properties.max_serialized_size = 1024 * 1024;
+  {
+    DDS::DataReaderQos datareader_qos;
+    ASSERT_TRUE(
+      get_datareader_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/chatter", datareader_qos,
+        &type_properties)) << "failed to get datareader qos";
+    const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+      datareader_qos.property, reader_property_name);
+    ASSERT_TRUE(property);
+    EXPECT_STREQ("1048576", property->value) <<
+      "expected pool buffers sized for a large bounded type";
+  }
+
+  type_properties.max_serialized_size = 4 * 1024 * 1024;
+  {
+    DDS::DataWriterQos datawriter_qos;
+    ASSERT_TRUE(
+      get_datawriter_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/chatter", datawriter_qos,
+        &type_properties)) << "failed to get datawriter qos";
+    const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+      datawriter_qos.property, writer_property_name);
+    ASSERT_TRUE(property);
+    EXPECT_STREQ("4096", property->value) <<
+      "expected the default size when the history would need too much memory";
+  }
+
+  type_properties.is_bounded = false;
+  type_properties.max_serialized_size = 8;
+  {
+    DDS::DataReaderQos datareader_qos;
+    ASSERT_TRUE(
+      get_datareader_qos(
+        participant, rmw_qos_profile_sensor_data, "rt/chatter", datareader_qos,
+        &type_properties)) << "failed to get datareader qos";
+    const DDS::Property_t * property = DDS::PropertyQosPolicyHelper::lookup_property(
+      datareader_qos.property, reader_property_name);
+    ASSERT_TRUE(property);
+    EXPECT_STREQ("4096", property->value) << "expected the default size for an unbounded type";
+  }
+}